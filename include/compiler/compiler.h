@@ -6,8 +6,24 @@
 
 #include "compiler/bytecode.h"
 #include "compiler/stack.h"
+#include "compiler/symbols.h"
 #include "lexer/token.h"
 #include "vm/pool.h"
+#include "utils/shape.h"
+
+#define LOCALS_MAX 256
+
+/**
+ * @brief Prototype of an object declaration, cloned by new instead of running the declaration body
+ * 
+ * Only declarations whose property initializers are all literals have a prototype,
+ * the shape of every other declaration is NULL.
+ * 
+ */
+typedef struct {
+    shape_t* shape;
+    value_t* slots;
+} object_template_t;
 
 /**
  * @brief Object representing a compiler holding the instruction array and a constant pool
@@ -18,6 +34,30 @@ typedef struct {
     token_t current_token;
     pool_t* pool;
     stack_long_t* continue_stack;
+
+    // slot indices of the parameters and local variables of the function being compiled (NULL outside of functions)
+    table_t* locals;
+    int local_count;
+
+    // dense indices of the top level variables, functions and enums, and of the object declarations
+    symbol_table_t* globals;
+    symbol_table_t* objects;
+
+    // number of natives declared as the first globals
+    int native_count;
+
+    // number of property access sites, each of which owns an inline cache at run time
+    int cache_count;
+
+    // last additive operator emitted and the bytecode range of its left operand, which lets
+    // assignments recognize expressions updating their own target, such as x = x + 1
+    int update_ip;
+    int update_operand_start;
+    int update_operand_end;
+
+    // prototypes of the object declarations, indexed like the declarations
+    object_template_t* templates;
+    int template_capacity;
 } compiler_t;
 
 /**
@@ -40,4 +80,39 @@ bytecode_t* compile(compiler_t* compiler_instance);
  */
 pool_t* compiler_get_pool();
 
+/**
+ * @brief Retrieves the number of global slots (top level variables, functions and enums) resolved at compile time
+ * 
+ * @return int number of global slots
+ */
+int compiler_get_global_count();
+
+/**
+ * @brief Retrieves the number of natives declared as the first global slots at compile time
+ * 
+ * @return int number of natives
+ */
+int compiler_get_native_count();
+
+/**
+ * @brief Retrieves the number of object declarations resolved at compile time
+ * 
+ * @return int number of object declarations
+ */
+int compiler_get_object_count();
+
+/**
+ * @brief Retrieves the number of property access sites (inline caches) emitted at compile time
+ * 
+ * @return int number of inline caches
+ */
+int compiler_get_cache_count();
+
+/**
+ * @brief Retrieves the prototypes of the object declarations resolved at compile time
+ * 
+ * @return object_template_t* array of prototypes indexed by object declaration
+ */
+object_template_t* compiler_get_templates();
+
 #endif
@@ -1,6 +1,8 @@
 #ifndef gen_lang_instruction_h
 #define gen_lang_instruction_h
 
+#include "utils/common.h"
+
 /**
  * @brief Instruction types
  * 
@@ -8,14 +10,16 @@
 typedef enum {
     OP_LOAD_CONST,
 
-    OP_DECLARE_VAR,
-    OP_LOAD_VAR,
-    OP_STORE_VAR,
+    OP_LOAD_GLOBAL,
+    OP_STORE_GLOBAL,
+    OP_LOAD_LOCAL,
+    OP_STORE_LOCAL,
 
     OP_FUNC_DEF,
     OP_FUNC_END,
     OP_RETURN,
     OP_CALL,
+    OP_CALL_DIRECT,
 
     OP_ENUM_DEF,
     OP_STORE_ENUM,
@@ -26,12 +30,17 @@ typedef enum {
     OP_NEW_OBJ,
     OP_LOAD_PROP,
     OP_LOAD_PROP_CONST,
+    OP_LOAD_PROP_SEPARATE,
     OP_STORE_PROP,
     OP_INIT_PROP,
 
     OP_ARRAY_DEF,
     OP_ARRAY_GET,
+    OP_ARRAY_GET_SEPARATE,
     OP_ARRAY_SET,
+    OP_SEPARATE,
+    OP_SLICE,
+    OP_MAP_DEF,
 
     OP_SIZEOF,
 
@@ -40,6 +49,8 @@ typedef enum {
 
     OP_ADD,
     OP_SUB,
+    OP_ADD_ASSIGN,
+    OP_SUB_ASSIGN,
     OP_MUL,
     OP_DIV,
     OP_DIV_FLOOR,
@@ -63,4 +74,12 @@ typedef enum {
     OP_NUM_INSTRUCTIONS,
 } op_code_t;
 
+/**
+ * @brief Retrieves the number of inline operand bytes following an instruction
+ * 
+ * @param instruction instruction to retrieve the operand size of
+ * @return int number of operand bytes following the instruction
+ */
+int instruction_operand_size(byte_t instruction);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef gen_lang_symbols_h
+#define gen_lang_symbols_h
+
+#include <stdbool.h>
+
+#include "utils/common.h"
+
+#define SYMBOL_TABLE_INITIAL_SIZE 16
+
+/**
+ * @brief Object representing a top level identifier resolved to a dense index
+ * 
+ */
+typedef struct {
+    char* identifier;
+    bool declared;
+    int line;
+} symbol_t;
+
+/**
+ * @brief Object mapping top level identifiers to dense indices in the order they are first referenced
+ * 
+ */
+typedef struct {
+    table_t* indices;
+    symbol_t* symbols;
+    int count;
+    int capacity;
+} symbol_table_t;
+
+/**
+ * @brief Initializes a new symbol table
+ * 
+ * @return symbol_table_t* pointer to the initialized symbol table
+ */
+symbol_table_t* symbol_table_init();
+
+/**
+ * @brief Retrieves the index of an identifier, assigning a new index if it has not been referenced yet
+ * 
+ * @param symbol_table symbol table to resolve the identifier in
+ * @param identifier identifier to resolve
+ * @param line line of the reference in the source code
+ * @return int index of the identifier
+ */
+int symbol_table_resolve(symbol_table_t* symbol_table, const char* identifier, int line);
+
+/**
+ * @brief Marks an identifier as declared and retrieves its index
+ * 
+ * @param symbol_table symbol table to declare the identifier in
+ * @param identifier identifier to declare
+ * @param line line of the declaration in the source code
+ * @return int index of the identifier
+ */
+int symbol_table_declare(symbol_table_t* symbol_table, const char* identifier, int line);
+
+/**
+ * @brief Retrieves the index of an already referenced identifier
+ * 
+ * @param symbol_table symbol table to look the identifier up in
+ * @param identifier identifier to look up
+ * @return int index of the identifier or -1 if it has not been referenced
+ */
+int symbol_table_find(symbol_table_t* symbol_table, const char* identifier);
+
+/**
+ * @brief Retrieves the first identifier that has been referenced but never declared
+ * 
+ * @param symbol_table symbol table to check
+ * @return symbol_t* pointer to the undeclared symbol or NULL if all symbols are declared
+ */
+symbol_t* symbol_table_undeclared(symbol_table_t* symbol_table);
+
+/**
+ * @brief Frees a symbol table from the memory
+ * 
+ * @param symbol_table symbol table to free
+ */
+void symbol_table_free(symbol_table_t* symbol_table);
+
+#endif
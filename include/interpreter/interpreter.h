@@ -1,10 +1,14 @@
 #ifndef gen_lang_interpreter_h
 #define gen_lang_interpreter_h
 
+#include <stdbool.h>
+
 /**
  * @brief Interpretes the source code and produces output
  * 
+ * @param source_code source code to interpret
+ * @param use_register_vm whether to run the bytecode on the register-based virtual machine instead of the stack-based one
  */
-void interpret(const char* source_code);
+void interpret(const char* source_code, bool use_register_vm);
 
 #endif
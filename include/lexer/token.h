@@ -36,6 +36,7 @@ typedef enum {
     TOKEN_OPEN_BRACKET, TOKEN_CLOSE_BRACKET,
 
     TOKEN_DOT,
+    TOKEN_COLON,
     TOKEN_COMMA,
     TOKEN_SEMICOLON,
     TOKEN_LINE,
@@ -0,0 +1,87 @@
+#ifndef gen_lang_bitset_h
+#define gen_lang_bitset_h
+
+#include "utils/common.h"
+
+#define BITSET_WORD_BITS 64
+#define BITSET_WORDS(size) (((size) + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS)
+
+/**
+ * @brief Fixed-size set of bits, packed 64 per word
+ *
+ * Bit i lives in bit i % 64 of word i / 64. The bits of the last word beyond size are always
+ * zero, so that counting and combining bitsets can process whole words. Like deques, bitsets are
+ * mutated in place by their builtins, and every variable holding a bitset refers to the same bits.
+ *
+ */
+struct bitset_t {
+    int size;
+    uint64_t* words;
+};
+
+/**
+ * @brief Checks whether a bit is set
+ *
+ * @param bitset bitset to read
+ * @param index index of the bit, between 0 and size - 1
+ * @return true if the bit is set, false otherwise
+ */
+static inline bool bitset_test(bitset_t* bitset, int index) {
+    return (bitset->words[index / BITSET_WORD_BITS] >> (index % BITSET_WORD_BITS)) & 1;
+}
+
+/**
+ * @brief Sets a bit to 1
+ *
+ * @param bitset bitset to update
+ * @param index index of the bit, between 0 and size - 1
+ */
+static inline void bitset_set(bitset_t* bitset, int index) {
+    bitset->words[index / BITSET_WORD_BITS] |= (uint64_t)1 << (index % BITSET_WORD_BITS);
+}
+
+/**
+ * @brief Sets a bit to 0
+ *
+ * @param bitset bitset to update
+ * @param index index of the bit, between 0 and size - 1
+ */
+static inline void bitset_clear(bitset_t* bitset, int index) {
+    bitset->words[index / BITSET_WORD_BITS] &= ~((uint64_t)1 << (index % BITSET_WORD_BITS));
+}
+
+/**
+ * @brief Creates a bitset with every bit set to 0 on the managed heap
+ *
+ * @param size number of bits
+ * @return bitset_t* created bitset
+ */
+bitset_t* bitset_init(int size);
+
+/**
+ * @brief Counts the bits set to 1
+ *
+ * @param bitset bitset to count
+ * @return long number of set bits
+ */
+long bitset_count(bitset_t* bitset);
+
+/**
+ * @brief Creates the union of two bitsets, as large as the larger one
+ *
+ * @param left first bitset
+ * @param right second bitset
+ * @return bitset_t* bitset with the bits set in either bitset
+ */
+bitset_t* bitset_union(bitset_t* left, bitset_t* right);
+
+/**
+ * @brief Creates the intersection of two bitsets, as large as the smaller one
+ *
+ * @param left first bitset
+ * @param right second bitset
+ * @return bitset_t* bitset with the bits set in both bitsets
+ */
+bitset_t* bitset_intersection(bitset_t* left, bitset_t* right);
+
+#endif
@@ -2,36 +2,182 @@
 #define gen_lang_common_h
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 // FORWARD REFERENCES
 
-typedef struct value_t value_t;
 typedef struct table_t table_t;
+typedef struct shape_t shape_t;
+typedef struct tree_t tree_t;
+typedef struct deque_t deque_t;
+typedef struct queue_t queue_t;
+typedef struct bitset_t bitset_t;
 
 // TYPEDEFS
 
 typedef uint8_t byte_t;
 
+// VALUE
+//
+// With NAN_BOXING defined, a value is a single 64-bit word: numbers are stored as plain
+// doubles and every other datatype lives in the payload of a quiet NaN, tagged by the sign
+// bit and the two lowest exponent-adjacent mantissa bits. Strings, objects, arrays and enums
+// are stored as heap pointers, maps under the tag of the quiet NaN itself, booleans as the
+// lowest payload bit, native functions as pointers to their static descriptions. The last tag
+// is shared by the collections manipulated through builtins, which tell their kind apart by the
+// two lowest bits of their pointer, always zero for 8 byte aligned heap objects. Without
+// NAN_BOXING, a value is a type tag followed by a union of the same payloads.
+//
+// Values must only be created and inspected through the macros below, so that either
+// representation can be selected without touching the rest of the interpreter.
+
+#define NAN_BOXING
+
+typedef enum { TYPE_NUMBER, TYPE_BOOLEAN, TYPE_STRING, TYPE_OBJECT, TYPE_ARRAY, TYPE_ENUM, TYPE_NATIVE, TYPE_MAP, TYPE_TREE, TYPE_DEQUE, TYPE_QUEUE, TYPE_BITSET } value_type;
+
+#ifdef NAN_BOXING
+typedef uint64_t value_t;
+#else
+typedef struct value_t value_t;
+#endif
+
 // DATATYPE TYPEDEFS
 
 typedef double number_t;
 typedef bool boolean_t;
 typedef char* string_t;
 typedef struct {
-    table_t* properties;
+    shape_t* shape;
+    int capacity;
+    value_t* slots;
 } object_t;
+typedef enum { ARRAY_NUMBERS, ARRAY_BOOLEANS, ARRAY_VALUES } array_kind;
 typedef struct {
     int size;
-    value_t* elements;
+    int capacity;
+    // number of variables, properties and elements the array is stored in
+    int refcount;
+    array_kind kind;
+    union {
+        number_t* numbers;
+        boolean_t* booleans;
+        value_t* values;
+    } elements;
 } array_t;
 typedef struct {
     table_t* values;
 } enum_t;
+typedef struct map_entry_t map_entry_t;
+typedef struct {
+    int count;
+    int capacity;
+    // number of variables, properties and elements the map is stored in
+    int refcount;
+    // entries in insertion order, followed by the indices of the entries laid out by hash
+    map_entry_t* entries;
+    int* buckets;
+} map_t;
+typedef value_t (*native_function_t)(value_t* args, int line);
+typedef struct {
+    const char* name;
+    int arity;
+    // receives exactly arity arguments
+    native_function_t function;
+} native_t;
 
-// VALUE
+#ifdef NAN_BOXING
+
+#define SIGN_BIT        ((uint64_t)0x8000000000000000)
+#define QNAN            ((uint64_t)0x7ffc000000000000)
+#define PAYLOAD_MASK    ((uint64_t)0x0000ffffffffffff)
+
+#define TAG_MAP         (QNAN)
+#define TAG_BOOLEAN     (QNAN | ((uint64_t)1 << 48))
+#define TAG_STRING      (QNAN | ((uint64_t)2 << 48))
+#define TAG_OBJECT      (QNAN | ((uint64_t)3 << 48))
+#define TAG_ARRAY       (QNAN | SIGN_BIT | ((uint64_t)1 << 48))
+#define TAG_ENUM        (QNAN | SIGN_BIT | ((uint64_t)2 << 48))
+#define TAG_NATIVE      (QNAN | SIGN_BIT | ((uint64_t)3 << 48))
+#define TAG_COLLECTION  (QNAN | SIGN_BIT)
+#define TAG_MASK        (QNAN | SIGN_BIT | ((uint64_t)3 << 48))
+
+// kinds of collections, in the order of their value types starting at TYPE_TREE
+#define COLLECTION_TREE ((uint64_t)0)
+#define COLLECTION_DEQUE ((uint64_t)1)
+#define COLLECTION_QUEUE ((uint64_t)2)
+#define COLLECTION_BITSET ((uint64_t)3)
+#define COLLECTION_MASK ((uint64_t)3)
 
-typedef enum { TYPE_NUMBER, TYPE_BOOLEAN, TYPE_STRING, TYPE_OBJECT, TYPE_ARRAY, TYPE_ENUM } value_type;
+static inline value_t number_to_value(number_t number) {
+    union { number_t number; value_t bits; } data;
+    data.number = number;
+    return data.bits;
+}
+
+static inline number_t value_to_number(value_t value) {
+    union { number_t number; value_t bits; } data;
+    data.bits = value;
+    return data.number;
+}
+
+#define IS_NUMBER(value)        (((value) & QNAN) != QNAN)
+#define IS_BOOLEAN(value)       (((value) & TAG_MASK) == TAG_BOOLEAN)
+#define IS_STRING(value)        (((value) & TAG_MASK) == TAG_STRING)
+#define IS_OBJECT(value)        (((value) & TAG_MASK) == TAG_OBJECT)
+#define IS_ARRAY(value)         (((value) & TAG_MASK) == TAG_ARRAY)
+#define IS_ENUM(value)          (((value) & TAG_MASK) == TAG_ENUM)
+#define IS_NATIVE(value)        (((value) & TAG_MASK) == TAG_NATIVE)
+#define IS_MAP(value)           (((value) & TAG_MASK) == TAG_MAP)
+#define IS_TREE(value)          (((value) & (TAG_MASK | COLLECTION_MASK)) == (TAG_COLLECTION | COLLECTION_TREE))
+#define IS_DEQUE(value)         (((value) & (TAG_MASK | COLLECTION_MASK)) == (TAG_COLLECTION | COLLECTION_DEQUE))
+#define IS_QUEUE(value)         (((value) & (TAG_MASK | COLLECTION_MASK)) == (TAG_COLLECTION | COLLECTION_QUEUE))
+#define IS_BITSET(value)        (((value) & (TAG_MASK | COLLECTION_MASK)) == (TAG_COLLECTION | COLLECTION_BITSET))
+
+#define AS_NUMBER(value)        value_to_number(value)
+#define AS_BOOLEAN(value)       ((boolean_t)((value) & 1))
+#define AS_STRING(value)        ((string_t)(uintptr_t)((value) & PAYLOAD_MASK))
+#define AS_OBJECT(value)        ((object_t*)(uintptr_t)((value) & PAYLOAD_MASK))
+#define AS_ARRAY(value)         ((array_t*)(uintptr_t)((value) & PAYLOAD_MASK))
+#define AS_ENUM(value)          ((enum_t*)(uintptr_t)((value) & PAYLOAD_MASK))
+#define AS_NATIVE(value)        ((native_t*)(uintptr_t)((value) & PAYLOAD_MASK))
+#define AS_MAP(value)           ((map_t*)(uintptr_t)((value) & PAYLOAD_MASK))
+#define AS_TREE(value)          ((tree_t*)(uintptr_t)((value) & PAYLOAD_MASK & ~COLLECTION_MASK))
+#define AS_DEQUE(value)         ((deque_t*)(uintptr_t)((value) & PAYLOAD_MASK & ~COLLECTION_MASK))
+#define AS_QUEUE(value)         ((queue_t*)(uintptr_t)((value) & PAYLOAD_MASK & ~COLLECTION_MASK))
+#define AS_BITSET(value)        ((bitset_t*)(uintptr_t)((value) & PAYLOAD_MASK & ~COLLECTION_MASK))
+
+#define NUMBER_VALUE(number)    number_to_value(number)
+#define BOOLEAN_VALUE(boolean)  (TAG_BOOLEAN | ((boolean) ? 1 : 0))
+#define STRING_VALUE(string)    (TAG_STRING | (uint64_t)(uintptr_t)(string))
+#define OBJECT_VALUE(object)    (TAG_OBJECT | (uint64_t)(uintptr_t)(object))
+#define ARRAY_VALUE(array)      (TAG_ARRAY | (uint64_t)(uintptr_t)(array))
+#define ENUM_VALUE(enumeration) (TAG_ENUM | (uint64_t)(uintptr_t)(enumeration))
+#define NATIVE_VALUE(native)    (TAG_NATIVE | (uint64_t)(uintptr_t)(native))
+#define MAP_VALUE(map)          (TAG_MAP | (uint64_t)(uintptr_t)(map))
+#define TREE_VALUE(tree)        (TAG_COLLECTION | COLLECTION_TREE | (uint64_t)(uintptr_t)(tree))
+#define DEQUE_VALUE(deque)      (TAG_COLLECTION | COLLECTION_DEQUE | (uint64_t)(uintptr_t)(deque))
+#define QUEUE_VALUE(queue)      (TAG_COLLECTION | COLLECTION_QUEUE | (uint64_t)(uintptr_t)(queue))
+#define BITSET_VALUE(bitset)    (TAG_COLLECTION | COLLECTION_BITSET | (uint64_t)(uintptr_t)(bitset))
+
+static inline value_type value_get_type(value_t value) {
+    if (IS_NUMBER(value)) {
+        return TYPE_NUMBER;
+    }
+
+    switch (value & TAG_MASK) {
+        case TAG_BOOLEAN: return TYPE_BOOLEAN;
+        case TAG_STRING: return TYPE_STRING;
+        case TAG_OBJECT: return TYPE_OBJECT;
+        case TAG_ARRAY: return TYPE_ARRAY;
+        case TAG_ENUM: return TYPE_ENUM;
+        case TAG_MAP: return TYPE_MAP;
+        case TAG_NATIVE: return TYPE_NATIVE;
+        default: return (value_type)(TYPE_TREE + (value & COLLECTION_MASK));
+    }
+}
+
+#else
 
 struct value_t {
     value_type type;
@@ -39,40 +185,281 @@ struct value_t {
         number_t number;
         boolean_t boolean;
         string_t string;
-        object_t object;
-        array_t array;
-        enum_t enumeration;
+        object_t* object;
+        array_t* array;
+        enum_t* enumeration;
+        native_t* native;
+        map_t* map;
+        tree_t* tree;
+        deque_t* deque;
+        queue_t* queue;
+        bitset_t* bitset;
     } as;
 };
 
+static inline value_t value_init(value_type type) {
+    value_t value;
+    value.type = type;
+    return value;
+}
+
+static inline value_t number_to_value(number_t number) {
+    value_t value = value_init(TYPE_NUMBER);
+    value.as.number = number;
+    return value;
+}
+
+static inline value_t boolean_to_value(boolean_t boolean) {
+    value_t value = value_init(TYPE_BOOLEAN);
+    value.as.boolean = boolean;
+    return value;
+}
+
+static inline value_t string_to_value(string_t string) {
+    value_t value = value_init(TYPE_STRING);
+    value.as.string = string;
+    return value;
+}
+
+static inline value_t object_to_value(object_t* object) {
+    value_t value = value_init(TYPE_OBJECT);
+    value.as.object = object;
+    return value;
+}
+
+static inline value_t array_to_value(array_t* array) {
+    value_t value = value_init(TYPE_ARRAY);
+    value.as.array = array;
+    return value;
+}
+
+static inline value_t enum_to_value(enum_t* enumeration) {
+    value_t value = value_init(TYPE_ENUM);
+    value.as.enumeration = enumeration;
+    return value;
+}
+
+static inline value_t native_to_value(native_t* native) {
+    value_t value = value_init(TYPE_NATIVE);
+    value.as.native = native;
+    return value;
+}
+
+static inline value_t map_to_value(map_t* map) {
+    value_t value = value_init(TYPE_MAP);
+    value.as.map = map;
+    return value;
+}
+
+static inline value_t tree_to_value(tree_t* tree) {
+    value_t value = value_init(TYPE_TREE);
+    value.as.tree = tree;
+    return value;
+}
+
+static inline value_t deque_to_value(deque_t* deque) {
+    value_t value = value_init(TYPE_DEQUE);
+    value.as.deque = deque;
+    return value;
+}
+
+static inline value_t queue_to_value(queue_t* queue) {
+    value_t value = value_init(TYPE_QUEUE);
+    value.as.queue = queue;
+    return value;
+}
+
+static inline value_t bitset_to_value(bitset_t* bitset) {
+    value_t value = value_init(TYPE_BITSET);
+    value.as.bitset = bitset;
+    return value;
+}
+
+#define IS_NUMBER(value)        ((value).type == TYPE_NUMBER)
+#define IS_BOOLEAN(value)       ((value).type == TYPE_BOOLEAN)
+#define IS_STRING(value)        ((value).type == TYPE_STRING)
+#define IS_OBJECT(value)        ((value).type == TYPE_OBJECT)
+#define IS_ARRAY(value)         ((value).type == TYPE_ARRAY)
+#define IS_ENUM(value)          ((value).type == TYPE_ENUM)
+#define IS_NATIVE(value)        ((value).type == TYPE_NATIVE)
+#define IS_MAP(value)           ((value).type == TYPE_MAP)
+#define IS_TREE(value)          ((value).type == TYPE_TREE)
+#define IS_DEQUE(value)         ((value).type == TYPE_DEQUE)
+#define IS_QUEUE(value)         ((value).type == TYPE_QUEUE)
+#define IS_BITSET(value)        ((value).type == TYPE_BITSET)
+
+#define AS_NUMBER(value)        ((value).as.number)
+#define AS_BOOLEAN(value)       ((value).as.boolean)
+#define AS_STRING(value)        ((value).as.string)
+#define AS_OBJECT(value)        ((value).as.object)
+#define AS_ARRAY(value)         ((value).as.array)
+#define AS_ENUM(value)          ((value).as.enumeration)
+#define AS_NATIVE(value)        ((value).as.native)
+#define AS_MAP(value)           ((value).as.map)
+#define AS_TREE(value)          ((value).as.tree)
+#define AS_DEQUE(value)         ((value).as.deque)
+#define AS_QUEUE(value)         ((value).as.queue)
+#define AS_BITSET(value)        ((value).as.bitset)
+
+#define NUMBER_VALUE(number)    number_to_value(number)
+#define BOOLEAN_VALUE(boolean)  boolean_to_value(boolean)
+#define STRING_VALUE(string)    string_to_value(string)
+#define OBJECT_VALUE(object)    object_to_value(object)
+#define ARRAY_VALUE(array)      array_to_value(array)
+#define ENUM_VALUE(enumeration) enum_to_value(enumeration)
+#define NATIVE_VALUE(native)    native_to_value(native)
+#define MAP_VALUE(map)          map_to_value(map)
+#define TREE_VALUE(tree)        tree_to_value(tree)
+#define DEQUE_VALUE(deque)      deque_to_value(deque)
+#define QUEUE_VALUE(queue)      queue_to_value(queue)
+#define BITSET_VALUE(bitset)    bitset_to_value(bitset)
+
+static inline value_type value_get_type(value_t value) {
+    return value.type;
+}
+
+#endif
+
 enum_t* enum_init();
 
-array_t* array_init(int size);
+// STRING
+
+// Concatenations of at least ROPE_MIN_LENGTH characters produce ropes, string values referencing
+// both operands instead of copying them. Ropes keep the length of a string, but their characters
+// only exist once flattened, so they must pass through string_flatten() before being read as
+// C strings. Flattening stores the characters in the rope, so every rope is flattened only once.
+//
+// Substrings of at least SLICE_MIN_LENGTH characters produce slices, string values viewing the
+// characters of a flat parent string instead of copying them. Like ropes, slices are not null
+// terminated, but string_chars() reads their characters in place.
+
+#define ROPE_MIN_LENGTH 64
+#define SLICE_MIN_LENGTH 32
+
+typedef struct {
+    value_t left;
+    value_t right;
+} rope_t;
+
+typedef struct {
+    value_t parent;
+    size_t offset;
+} slice_t;
+
+char* string_concat(char* left, char* right);
+char* string_slice(char* string, size_t start, size_t length);
+char* string_flatten(char* string);
+void string_for_each_segment(char* string, void (*callback)(const char* chars, size_t length, void* context), void* context);
+
+// Arrays keep spare capacity, doubling it when an append finds them full and halving it
+// once removals leave them less than a quarter full, so appends and removals are amortized O(1).
+
+#define ARRAY_MIN_CAPACITY 4
+
+// Arrays and maps have value semantics, implemented by copy-on-write. The refcount of an array counts
+// the variables, properties and elements it is stored in, values on the stack or in registers are not
+// counted. An array stored in one place only may be mutated in place by the assignment updating
+// that place, an array stored in several places is copied first. Counts are never decremented when
+// frames or containers die, so they may overestimate the number of owners, which only costs a copy.
+
+// Arrays store their elements by kind: arrays of numbers only and of booleans only are packed as
+// plain doubles and bools, without type tags, anything else is stored as values. Storing an element
+// that does not fit the kind converts the array to ARRAY_VALUES, except for empty arrays, which
+// take the kind of their first element, and array_pack_numbers() converts it back once it holds
+// numbers only. Only ARRAY_VALUES arrays count their elements, take write barriers and are traced
+// by the garbage collector.
+
+array_t* array_init(int size, array_kind kind);
+array_t* array_copy(array_t* array);
+array_kind array_kind_of(value_t element);
+size_t array_element_size(array_kind kind);
 void array_add_element(array_t* array, int index, value_t element);
+void array_set_element(array_t* array, int index, value_t element);
 value_t array_get_element(array_t* array, int index);
 void array_append(array_t* array, value_t element);
 void array_remove(array_t* array, int count);
+bool array_pack_numbers(array_t* array);
+
+static inline void value_retain(value_t value) {
+    if (IS_ARRAY(value)) {
+        AS_ARRAY(value)->refcount++;
+    } else if (IS_MAP(value)) {
+        AS_MAP(value)->refcount++;
+    }
+}
+
+static inline void value_release(value_t value) {
+    if (IS_ARRAY(value) && AS_ARRAY(value)->refcount > 0) {
+        AS_ARRAY(value)->refcount--;
+    } else if (IS_MAP(value) && AS_MAP(value)->refcount > 0) {
+        AS_MAP(value)->refcount--;
+    }
+}
+
+// stores a value into a counted place (variable, property or element), replacing its previous value
+static inline void value_store(value_t* place, value_t value) {
+    value_retain(value);
+    value_release(*place);
+    *place = value;
+}
 
 object_t* object_init();
+object_t* object_clone(shape_t* shape, const value_t* slots);
+value_t* object_get_property(object_t* object, const char* identifier);
 void object_add_property(object_t* object, char* identifier, value_t element);
+void object_transition(object_t* object, shape_t* shape);
+
+// MAP
+
+// Maps keep their entries in insertion order, and index them by hash in twice as many buckets,
+// probed linearly. Capacities are powers of two and double once the entries are full, so lookups,
+// insertions and deletions are O(1) on average. Deleting an entry moves the last entry into its
+// place, so insertion order is kept until the first deletion. Keys are numbers, booleans or strings,
+// strings being compared by content.
+
+#define MAP_MIN_CAPACITY 8
+
+struct map_entry_t {
+    value_t key;
+    value_t value;
+    unsigned long hash;
+};
+
+static inline bool map_is_key(value_t key) {
+    return IS_NUMBER(key) || IS_BOOLEAN(key) || IS_STRING(key);
+}
+
+map_t* map_init(int capacity);
+map_t* map_copy(map_t* map);
+value_t* map_get(map_t* map, value_t key);
+void map_set(map_t* map, value_t key, value_t value);
+bool map_delete(map_t* map, value_t key);
 
 // TABLE
 
-typedef struct entry_t {
+// An open addressing hash table with linear probing. Entries store the hash of their key, so
+// probes only compare keys whose hashes match, and the table doubles once it is 3/4 full.
+// Deletion shifts the following entries of the probe sequence back, so no tombstones are left.
+// Keys must be managed strings, the table reads their cached hash and length instead of scanning them.
+
+#define TABLE_MAX_LOAD_NUMERATOR 3
+#define TABLE_MAX_LOAD_DENOMINATOR 4
+
+typedef struct {
+    // interned string, NULL for an empty bucket
     char* key;
+    unsigned long hash;
     value_t value;
-    struct entry_t* next;
 } entry_t;
 
 struct table_t {
     int size;
     int capacity;
-    entry_t** buckets;
+    entry_t* entries;
 };
 
 table_t* table_init(int capacity);
 void table_free(table_t* table);
-void entry_free(entry_t* entry);
 
 void table_set(table_t* table, const char* key, value_t value);
 value_t* table_get(table_t* table, const char* key);
@@ -83,6 +470,9 @@ void table_delete(table_t* table, const char* key);
 byte_t* uint16_to_bytes(uint16_t value);
 uint16_t bytes_to_uint16(byte_t* bytes);
 
+byte_t* uint32_to_bytes(uint32_t value);
+uint32_t bytes_to_uint32(byte_t* bytes);
+
 byte_t* string_to_bytes(const char* str, size_t* size);
 char* bytes_to_string(byte_t* bytes, size_t size);
 
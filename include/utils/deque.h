@@ -0,0 +1,74 @@
+#ifndef gen_lang_deque_h
+#define gen_lang_deque_h
+
+#include "utils/common.h"
+
+#define DEQUE_MIN_CAPACITY 8
+
+/**
+ * @brief Double-ended queue, a ring buffer of values
+ *
+ * The values are stored from head onwards, wrapping around the end of the buffer. Capacities are
+ * powers of two, so positions wrap with a mask, and double when the buffer is full, so pushing
+ * and popping at both ends take amortized O(1) time. Like ordered maps, deques are mutated in
+ * place by their builtins, and every variable holding a deque refers to the same buffer.
+ *
+ */
+struct deque_t {
+    int head;
+    int count;
+    int capacity;
+    value_t* values;
+};
+
+/**
+ * @brief Retrieves the slot of the value at a position, counted from the front
+ *
+ * @param deque deque to read
+ * @param index position of the value, between 0 and count - 1
+ * @return value_t* slot of the value
+ */
+static inline value_t* deque_at(deque_t* deque, int index) {
+    return &deque->values[(deque->head + index) & (deque->capacity - 1)];
+}
+
+/**
+ * @brief Creates an empty deque on the managed heap
+ *
+ * @return deque_t* created deque
+ */
+deque_t* deque_init();
+
+/**
+ * @brief Adds a value after the last value of a deque
+ *
+ * @param deque deque to update
+ * @param value added value
+ */
+void deque_push_back(deque_t* deque, value_t value);
+
+/**
+ * @brief Adds a value before the first value of a deque
+ *
+ * @param deque deque to update
+ * @param value added value
+ */
+void deque_push_front(deque_t* deque, value_t value);
+
+/**
+ * @brief Removes the last value of a non-empty deque
+ *
+ * @param deque deque to update
+ * @return value_t removed value
+ */
+value_t deque_pop_back(deque_t* deque);
+
+/**
+ * @brief Removes the first value of a non-empty deque
+ *
+ * @param deque deque to update
+ * @return value_t removed value
+ */
+value_t deque_pop_front(deque_t* deque);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef gen_lang_kernels_h
+#define gen_lang_kernels_h
+
+#include "utils/common.h"
+
+// Loops over packed arrays of numbers and over the words of bitsets. On x86, the first call
+// checks the features of the CPU and selects AVX2 or SSE2 implementations, other CPUs use the
+// scalar ones. Vectorized sums and dot products add the elements in a different order than a
+// sequential loop, so their results may differ in the last bits when the additions round.
+
+/**
+ * @brief Adds all numbers of an array
+ *
+ * @param values numbers to add
+ * @param count number of numbers
+ * @return number_t sum of the numbers, 0 for an empty array
+ */
+number_t kernel_sum(const number_t* values, int count);
+
+/**
+ * @brief Retrieves the smallest number of a non-empty array
+ *
+ * @param values numbers to search
+ * @param count number of numbers, at least 1
+ * @return number_t smallest number
+ */
+number_t kernel_min(const number_t* values, int count);
+
+/**
+ * @brief Retrieves the largest number of a non-empty array
+ *
+ * @param values numbers to search
+ * @param count number of numbers, at least 1
+ * @return number_t largest number
+ */
+number_t kernel_max(const number_t* values, int count);
+
+/**
+ * @brief Computes the dot product of two arrays of the same size
+ *
+ * @param left first array of numbers
+ * @param right second array of numbers
+ * @param count number of numbers in each array
+ * @return number_t sum of the products of the numbers at the same index
+ */
+number_t kernel_dot(const number_t* left, const number_t* right, int count);
+
+/**
+ * @brief Multiplies all numbers of an array by a factor
+ *
+ * @param destination array receiving the products, may be the source array
+ * @param source numbers to multiply
+ * @param factor factor to multiply by
+ * @param count number of numbers
+ */
+void kernel_scale(number_t* destination, const number_t* source, number_t factor, int count);
+
+/**
+ * @brief Sets all numbers of an array to a single number
+ *
+ * @param destination array to fill
+ * @param value number to fill the array with
+ * @param count number of numbers
+ */
+void kernel_fill(number_t* destination, number_t value, int count);
+
+/**
+ * @brief Computes the bitwise or of two arrays of words of the same size
+ *
+ * @param destination array receiving the results, may be one of the operands
+ * @param left first array of words
+ * @param right second array of words
+ * @param count number of words in each array
+ */
+void kernel_or(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count);
+
+/**
+ * @brief Computes the bitwise and of two arrays of words of the same size
+ *
+ * @param destination array receiving the results, may be one of the operands
+ * @param left first array of words
+ * @param right second array of words
+ * @param count number of words in each array
+ */
+void kernel_and(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count);
+
+/**
+ * @brief Counts the set bits of an array of words
+ *
+ * @param words words to count
+ * @param count number of words
+ * @return long number of bits set to 1
+ */
+long kernel_popcount(const uint64_t* words, int count);
+
+#endif
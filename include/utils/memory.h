@@ -0,0 +1,270 @@
+#ifndef gen_lang_memory_h
+#define gen_lang_memory_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "utils/common.h"
+
+#define MEMORY_INITIAL_THRESHOLD (1024 * 1024)
+#define MEMORY_GROWTH_FACTOR 2
+#define NURSERY_SIZE (1024 * 1024)
+#define NURSERY_MAX_OBJECT_SIZE (NURSERY_SIZE / 16)
+
+/**
+ * @brief Heap object types
+ *
+ */
+typedef enum { HEAP_STRING, HEAP_ARRAY, HEAP_OBJECT, HEAP_ENUM, HEAP_ROPE, HEAP_SLICE, HEAP_MAP, HEAP_TREE, HEAP_DEQUE, HEAP_QUEUE, HEAP_BITSET } heap_type;
+
+/**
+ * @brief Header preceding every heap allocation managed by the garbage collector
+ *
+ * Objects in the old generation are linked through next. Objects in the nursery are
+ * not linked, and once copied out by a minor collection, marked is set and next
+ * holds the forwarding address of the promoted copy. Interned strings are not linked
+ * either, they are never moved nor freed and stay marked for their whole lifetime.
+ *
+ */
+typedef struct heap_header_t {
+    struct heap_header_t* next;
+    byte_t type;
+    bool marked;
+    bool remembered;
+} heap_header_t;
+
+#define STRING_INTERNED 0x01
+#define STRING_HASHED 0x02
+#define STRING_ROPE 0x04
+#define STRING_SLICE 0x08
+
+/**
+ * @brief Prefix stored between the heap header and the characters of every managed string
+ *
+ * String values point to the null terminated characters, so they can still be passed to the C
+ * string functions, while the length and the hash of the string are read from this prefix
+ * instead of being recomputed on every operation. Ropes and slices share the prefix, followed
+ * by a rope_t or a slice_t instead of the characters.
+ *
+ */
+typedef struct {
+    size_t length;
+    unsigned long hash;
+    byte_t flags;
+} string_header_t;
+
+/**
+ * @brief Set when the managed heap has grown past the collection threshold
+ *
+ * The collector never runs on its own. The virtual machines poll this flag at safepoints,
+ * where every live value is reachable from their roots, and call memory_collect().
+ *
+ */
+extern bool memory_collection_requested;
+
+extern byte_t* memory_nursery_start;
+extern byte_t* memory_nursery_end;
+
+/**
+ * @brief Checks whether a heap object lives in the nursery (young generation)
+ *
+ * @param pointer pointer to the heap object
+ * @return true if the object is in the nursery, false otherwise
+ */
+static inline bool memory_in_nursery(const void* pointer) {
+    return (const byte_t*)pointer >= memory_nursery_start && (const byte_t*)pointer < memory_nursery_end;
+}
+
+/**
+ * @brief Adds an old generation object to the remembered set scanned by minor collections
+ *
+ * @param container old generation heap object that now references the nursery
+ */
+void memory_remember(void* container);
+
+/**
+ * @brief Records a store of a value into a heap object
+ *
+ * Minor collections only scan the roots and the remembered set, so every store that may create
+ * a reference from the old generation into the nursery must pass through this barrier.
+ *
+ * @param container heap object the value is stored into
+ * @param value stored value
+ */
+static inline void memory_write_barrier(void* container, value_t value) {
+    void* pointer;
+
+    switch (value_get_type(value)) {
+        case TYPE_STRING: pointer = AS_STRING(value); break;
+        case TYPE_ARRAY: pointer = AS_ARRAY(value); break;
+        case TYPE_OBJECT: pointer = AS_OBJECT(value); break;
+        case TYPE_ENUM: pointer = AS_ENUM(value); break;
+        case TYPE_MAP: pointer = AS_MAP(value); break;
+        case TYPE_TREE: pointer = AS_TREE(value); break;
+        case TYPE_DEQUE: pointer = AS_DEQUE(value); break;
+        case TYPE_QUEUE: pointer = AS_QUEUE(value); break;
+        case TYPE_BITSET: pointer = AS_BITSET(value); break;
+        default: return;
+    }
+
+    if (memory_in_nursery(pointer) && !memory_in_nursery(container)) {
+        memory_remember(container);
+    }
+}
+
+/**
+ * @brief Allocates a new heap object managed by the garbage collector
+ *
+ * Small objects are bump allocated in the nursery. Large objects, and every object allocated
+ * while the nursery is full and waiting for a minor collection, go to the old generation.
+ *
+ * @param type type of the heap object
+ * @param size size of the object in bytes (excluding the header)
+ * @return void* pointer to the object (just past its header)
+ */
+void* memory_allocate(heap_type type, size_t size);
+
+/**
+ * @brief Reallocates a buffer owned by a heap object and accounts for the size difference
+ *
+ * @param pointer buffer to reallocate
+ * @param old_size current size of the buffer in bytes
+ * @param new_size new size of the buffer in bytes
+ * @return void* pointer to the reallocated buffer
+ */
+void* memory_reallocate(void* pointer, size_t old_size, size_t new_size);
+
+/**
+ * @brief Allocates a new managed string
+ *
+ * The characters must not be modified once the hash of the string has been computed.
+ *
+ * @param length length of the string (excluding the null terminator)
+ * @return char* pointer to the uninitialized, null terminated string
+ */
+char* memory_allocate_string(size_t length);
+
+/**
+ * @brief Copies characters into a new managed string
+ *
+ * @param chars characters to copy
+ * @param length number of characters to copy
+ * @return char* pointer to the new null terminated string
+ */
+char* memory_copy_string(const char* chars, size_t length);
+
+/**
+ * @brief Retrieves the unique interned string with the given characters, creating it on first use
+ *
+ * Two interned strings are equal if and only if they are the same pointer.
+ *
+ * @param chars characters of the string
+ * @param length number of characters
+ * @return char* pointer to the interned null terminated string
+ */
+char* memory_intern_string(const char* chars, size_t length);
+
+/**
+ * @brief Retrieves the prefix of a managed string
+ *
+ * @param string managed string
+ * @return string_header_t* prefix holding the length, hash and flags of the string
+ */
+static inline string_header_t* string_header(const char* string) {
+    return ((string_header_t*)string) - 1;
+}
+
+/**
+ * @brief Retrieves the length of a managed string without scanning its characters
+ *
+ * @param string managed string
+ * @return size_t length of the string (excluding the null terminator)
+ */
+static inline size_t string_length(const char* string) {
+    return string_header(string)->length;
+}
+
+/**
+ * @brief Retrieves the characters of a managed string, flattening ropes
+ *
+ * The characters of slices are read in place from their parent, so they are only valid for
+ * string_length() characters and are not null terminated.
+ *
+ * @param string managed string
+ * @return const char* characters of the string
+ */
+static inline const char* string_chars(const char* string) {
+    byte_t flags = string_header(string)->flags;
+
+    if (flags & STRING_SLICE) {
+        slice_t* slice = (slice_t*)string;
+        return AS_STRING(slice->parent) + slice->offset;
+    }
+
+    return flags & STRING_ROPE ? string_flatten((char*)string) : string;
+}
+
+/**
+ * @brief Computes the hash of a string's characters
+ *
+ * @param chars characters to hash
+ * @param length number of characters
+ * @return unsigned long hash of the characters
+ */
+unsigned long memory_hash_chars(const char* chars, size_t length);
+
+/**
+ * @brief Retrieves the hash of a managed string, computing it on first use
+ *
+ * @param string managed string
+ * @return unsigned long hash of the string
+ */
+static inline unsigned long string_hash(const char* string) {
+    string_header_t* header = string_header(string);
+
+    if (!(header->flags & STRING_HASHED)) {
+        header->hash = memory_hash_chars(string_chars(string), header->length);
+        header->flags |= STRING_HASHED;
+    }
+
+    return header->hash;
+}
+
+/**
+ * @brief Retrieves the interned string consisting of a single character
+ *
+ * @param character character of the string
+ * @return char* pointer to the interned null terminated string
+ */
+char* memory_character_string(char character);
+
+/**
+ * @brief Checks whether a managed string is interned
+ *
+ * @param string managed string
+ * @return true if the string is interned, false otherwise
+ */
+static inline bool memory_is_interned(const char* string) {
+    return string_header(string)->flags & STRING_INTERNED;
+}
+
+/**
+ * @brief Marks a sequence of root values as live
+ *
+ * During a minor collection, values referencing the nursery are updated in place to point
+ * to their promoted copies, so roots must be passed as the slots that hold them.
+ *
+ * @param values pointer to the first value
+ * @param count number of values to mark
+ */
+void memory_mark_values(value_t* values, int count);
+
+/**
+ * @brief Runs a minor collection, promoting every live nursery object to the old generation,
+ * followed by a full mark-and-sweep collection of the old generation once it outgrows its threshold
+ *
+ * @param mark_roots function marking every root of the running virtual machine
+ */
+void memory_collect(void (*mark_roots)());
+
+#endif
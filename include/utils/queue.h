@@ -0,0 +1,51 @@
+#ifndef gen_lang_queue_h
+#define gen_lang_queue_h
+
+#include "utils/common.h"
+
+#define QUEUE_ARITY 4
+#define QUEUE_MIN_CAPACITY 8
+
+/**
+ * @brief Priority queue, an implicit QUEUE_ARITY-ary min-heap of values ordered by number
+ *
+ * The children of the entry at index i are at indices QUEUE_ARITY * i + 1 to QUEUE_ARITY * i +
+ * QUEUE_ARITY. Priorities and values are stored in separate arrays, so that sifting compares the
+ * priorities of all children of an entry within a single cache line, and a wider heap halves the
+ * depth of a binary one. Entries of equal priority are popped in no particular order. Like deques,
+ * priority queues are mutated in place by their builtins, and every variable holding a priority
+ * queue refers to the same heap.
+ *
+ */
+struct queue_t {
+    int count;
+    int capacity;
+    number_t* priorities;
+    value_t* values;
+};
+
+/**
+ * @brief Creates an empty priority queue on the managed heap
+ *
+ * @return queue_t* created priority queue
+ */
+queue_t* queue_init();
+
+/**
+ * @brief Adds a value with a priority to a priority queue
+ *
+ * @param queue priority queue to update
+ * @param priority priority of the value, lower priorities are popped first
+ * @param value added value
+ */
+void queue_push(queue_t* queue, number_t priority, value_t value);
+
+/**
+ * @brief Removes the value with the lowest priority from a non-empty priority queue
+ *
+ * @param queue priority queue to update
+ * @return value_t removed value
+ */
+value_t queue_pop(queue_t* queue);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef gen_lang_shape_h
+#define gen_lang_shape_h
+
+#include "utils/common.h"
+
+#define INLINE_CACHE_SIZE 4
+
+/**
+ * @brief Hidden class describing the layout of an object
+ *
+ * Shapes form a transition tree rooted at the empty shape. Adding a property to an object moves
+ * it to the child shape for that property, so objects that received the same properties in the
+ * same order share a single shape, and a property always lives in the same slot of the object.
+ * Shapes are never freed.
+ *
+ */
+struct shape_t {
+    struct shape_t* parent;
+
+    // interned name of the property added by the transition from the parent shape and the slot it occupies
+    char* name;
+    int slot;
+
+    // number of properties (slots) of the objects with this shape
+    int count;
+
+    // shapes reachable from this shape by adding one property
+    struct shape_t* transitions;
+    struct shape_t* sibling;
+};
+
+/**
+ * @brief Entry of an inline cache
+ *
+ * For loads and stores to an existing property, transition equals shape. For stores adding a new
+ * property, transition is the shape the object moves to and slot is the slot of the new property.
+ *
+ */
+typedef struct {
+    shape_t* shape;
+    shape_t* transition;
+    int slot;
+} inline_cache_entry_t;
+
+/**
+ * @brief Polymorphic inline cache of a single property access site
+ *
+ * Holds up to INLINE_CACHE_SIZE shapes seen at the site, sites seeing more shapes fall back to
+ * looking up the property in the shape of the object.
+ *
+ */
+typedef struct {
+    int count;
+    inline_cache_entry_t entries[INLINE_CACHE_SIZE];
+} inline_cache_t;
+
+/**
+ * @brief Retrieves the shape of an object without any properties
+ *
+ * @return shape_t* root of the shape transition tree
+ */
+shape_t* shape_root();
+
+/**
+ * @brief Finds the slot of a property in a shape
+ *
+ * @param shape shape to search
+ * @param name interned name of the property
+ * @return int slot of the property, -1 if the shape has no such property
+ */
+int shape_lookup(shape_t* shape, const char* name);
+
+/**
+ * @brief Retrieves the shape of an object after adding a new property to it, creating it on first use
+ *
+ * @param shape current shape of the object
+ * @param name interned name of the added property
+ * @return shape_t* shape with the added property in its last slot
+ */
+shape_t* shape_transition(shape_t* shape, char* name);
+
+#endif
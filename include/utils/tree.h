@@ -0,0 +1,131 @@
+#ifndef gen_lang_tree_h
+#define gen_lang_tree_h
+
+#include <stddef.h>
+
+#include "utils/common.h"
+
+#define TREE_MIN_DEGREE 16
+#define TREE_MAX_KEYS (2 * TREE_MIN_DEGREE - 1)
+
+/**
+ * @brief Node of the B-tree backing an ordered map
+ *
+ * Keys and values are stored in separate arrays, so that searching a node only reads its keys.
+ * Every node but the root holds between TREE_MIN_DEGREE - 1 and TREE_MAX_KEYS keys, and inner
+ * nodes hold one more child than keys. Leaves are allocated without the children array.
+ *
+ */
+typedef struct tree_node_t {
+    int count;
+    bool leaf;
+    value_t keys[TREE_MAX_KEYS];
+    value_t values[TREE_MAX_KEYS];
+    struct tree_node_t* children[TREE_MAX_KEYS + 1];
+} tree_node_t;
+
+/**
+ * @brief Ordered map, a B-tree of key value pairs sorted by key
+ *
+ * Keys are numbers or strings, numbers are ordered before strings, and strings are ordered by
+ * their bytes. Ordered maps are mutated in place by their builtins, so unlike arrays and maps,
+ * every variable holding an ordered map refers to the same tree, like objects do.
+ *
+ */
+struct tree_t {
+    tree_node_t* root;
+    int count;
+};
+
+/**
+ * @brief Checks whether a value can be a key of an ordered map
+ *
+ * @param key value to check
+ * @return true for strings and numbers other than NaN, false otherwise
+ */
+static inline bool tree_is_key(value_t key) {
+    return IS_STRING(key) || (IS_NUMBER(key) && AS_NUMBER(key) == AS_NUMBER(key));
+}
+
+/**
+ * @brief Creates an empty ordered map on the managed heap
+ *
+ * @return tree_t* created ordered map
+ */
+tree_t* tree_init();
+
+/**
+ * @brief Looks up the value of a key
+ *
+ * @param tree ordered map to search
+ * @param key key to look up
+ * @return value_t* slot holding the value of the key, NULL if the key is missing
+ */
+value_t* tree_get(tree_t* tree, value_t key);
+
+/**
+ * @brief Sets the value of a key, inserting the key if it is missing
+ *
+ * @param tree ordered map to update
+ * @param key key to set
+ * @param value value of the key
+ */
+void tree_set(tree_t* tree, value_t key, value_t value);
+
+/**
+ * @brief Finds the largest key less than or equal to a key
+ *
+ * @param tree ordered map to search
+ * @param key key to compare with
+ * @return value_t* slot holding the found key, NULL if every key is larger
+ */
+value_t* tree_floor(tree_t* tree, value_t key);
+
+/**
+ * @brief Finds the smallest key greater than or equal to a key
+ *
+ * @param tree ordered map to search
+ * @param key key to compare with
+ * @return value_t* slot holding the found key, NULL if every key is smaller
+ */
+value_t* tree_ceiling(tree_t* tree, value_t key);
+
+/**
+ * @brief Calls a function for every entry with a key between two bounds, in ascending key order
+ *
+ * Subtrees outside of the bounds are skipped, so visiting k entries of a tree of n entries takes
+ * O(log n + k) steps.
+ *
+ * @param tree ordered map to walk
+ * @param low smallest key to visit
+ * @param high largest key to visit
+ * @param callback function receiving every key and value
+ * @param context pointer passed to the callback
+ */
+void tree_range(tree_t* tree, value_t low, value_t high, void (*callback)(value_t key, value_t value, void* context), void* context);
+
+/**
+ * @brief Calls a function for every entry, in ascending key order
+ *
+ * @param tree ordered map to walk
+ * @param callback function receiving every key and value
+ * @param context pointer passed to the callback
+ */
+void tree_for_each(tree_t* tree, void (*callback)(value_t key, value_t value, void* context), void* context);
+
+/**
+ * @brief Calls a function for the slot of every key and value, for the garbage collector
+ *
+ * @param tree ordered map to walk
+ * @param visit function receiving every slot
+ */
+void tree_visit_slots(tree_t* tree, void (*visit)(value_t* slot));
+
+/**
+ * @brief Frees the nodes of an ordered map, but not the map itself
+ *
+ * @param tree ordered map being freed
+ */
+void tree_free_nodes(tree_t* tree);
+
+#endif
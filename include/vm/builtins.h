@@ -0,0 +1,45 @@
+#ifndef gen_lang_builtins_h
+#define gen_lang_builtins_h
+
+#include "utils/common.h"
+
+// Builtins are the natives registered for every program:
+//
+//   sum(array), min(array), max(array)  reduce an array of numbers
+//   dot(left, right)                    sums the products of two arrays of numbers of the same size
+//   scale(array, factor)                multiplies an array of numbers by a factor into a new array
+//   fill(size, value)                   creates an array of size elements equal to value
+//   keys(map), values(map)              lists the keys or the values of a map in insertion order,
+//                                       or of an ordered map in key order
+//   has(map, key)                       tells whether a map or an ordered map holds a key
+//   tree()                              creates an empty ordered map
+//   insert(tree, key, value)            sets the value of a key of an ordered map, returns the map
+//   lookup(tree, key)                   retrieves the value of a key of an ordered map
+//   floor_key(tree, key, fallback)      finds the largest key <= key, fallback if there is none
+//   ceiling_key(tree, key, fallback)    finds the smallest key >= key, fallback if there is none
+//   range_keys(tree, low, high)         lists the keys between low and high included, in order
+//   range_values(tree, low, high)       lists the values of the keys between low and high included
+//   deque()                             creates an empty deque
+//   push_back(deque, value)             adds a value at the back of a deque, returns the deque
+//   push_front(deque, value)            adds a value at the front of a deque, returns the deque
+//   pop_back(deque), pop_front(deque)   removes and returns the value at the back or the front
+//   back(deque), front(deque)           retrieves the value at the back or the front
+//   priority_queue()                    creates an empty priority queue
+//   push(queue, priority, value)        adds a value with a numeric priority, returns the queue
+//   pop(queue)                          removes and returns the value with the lowest priority
+//   peek(queue), peek_priority(queue)   retrieves the value with the lowest priority, or that priority
+//   bitset(size)                        creates a bitset of size bits set to 0
+//   set_bit(bitset, index)              sets a bit to 1, returns the bitset
+//   clear_bit(bitset, index)            sets a bit to 0, returns the bitset
+//   test_bit(bitset, index)             tells whether a bit is set
+//   popcount(bitset)                    counts the bits set to 1
+//   union(left, right)                  creates a bitset of the bits set in either bitset
+//   intersection(left, right)           creates a bitset of the bits set in both bitsets
+
+/**
+ * @brief Registers the builtins as natives
+ * 
+ */
+void builtins_register();
+
+#endif
@@ -3,13 +3,19 @@
 
 #include "utils/common.h"
 
+#define CALL_STACK_SIZE 256
+
 /**
  * @brief Object representing a call frame
  * 
+ * Frames hold the state of the caller restored on return. The locals of the callee are a window
+ * of the value stack starting at its first argument, so calls neither copy arguments nor allocate.
+ * 
  */
 typedef struct {
     long ra;
-    table_t* table;
+    value_t* locals;
+    value_t* stack_top;
 } call_frame_t;
 
 /**
@@ -17,7 +23,7 @@ typedef struct {
  * 
  */
 typedef struct {
-    call_frame_t call_frames[256];
+    call_frame_t call_frames[CALL_STACK_SIZE];
     call_frame_t* call_frame_top;
 } call_stack_t;
 
@@ -52,13 +58,6 @@ call_frame_t* call_stack_pop(call_stack_t* call_stack);
  */
 call_frame_t* call_stack_current(call_stack_t* call_stack);
 
-/**
- * @brief Frees a call frame from the memory
- * 
- * @param call_frame call frame to free
- */
-void call_frame_free(call_frame_t* call_frame);
-
 /**
  * @brief Frees a call stack from the memory
  * 
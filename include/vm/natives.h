@@ -0,0 +1,47 @@
+#ifndef gen_lang_natives_h
+#define gen_lang_natives_h
+
+#include "utils/common.h"
+
+// Natives are C functions GEN programs call like their own functions. The compiler declares every
+// native registered so far before anything else, so native i lives in global slot i, and a program
+// declaring a function of the same name replaces the native. Natives run without a call frame, they
+// receive their arguments in place and their result replaces them. The builtins are registered first.
+
+#define NATIVES_INITIAL_SIZE 16
+
+/**
+ * @brief Registers a native function, replacing a native of the same name
+ * 
+ * Natives must be registered before compiling the programs calling them.
+ * 
+ * @param name name programs call the native by
+ * @param arity number of arguments the native receives
+ * @param function C function implementing the native
+ */
+void natives_register(const char* name, int arity, native_function_t function);
+
+/**
+ * @brief Retrieves the number of registered natives
+ * 
+ * @return int number of registered natives
+ */
+int natives_count();
+
+/**
+ * @brief Retrieves a registered native by its registration index
+ * 
+ * @param index registration index of the native
+ * @return native_t* pointer to the native, which stays valid for the lifetime of the program
+ */
+native_t* natives_get(int index);
+
+/**
+ * @brief Stores the first natives into the first global slots of a virtual machine
+ * 
+ * @param globals globals of the virtual machine
+ * @param count number of natives declared by the compiler
+ */
+void natives_install(value_t* globals, int count);
+
+#endif
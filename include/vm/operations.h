@@ -0,0 +1,217 @@
+#ifndef gen_lang_operations_h
+#define gen_lang_operations_h
+
+#include "utils/common.h"
+#include "utils/shape.h"
+
+/**
+ * @brief Adds two values (numbers, string concatenation or array append)
+ * 
+ * @param left left operand
+ * @param right right operand
+ * @param line line in the source code used for error reporting
+ * @return value_t result of the addition
+ */
+value_t operation_add(value_t left, value_t right, int line);
+
+/**
+ * @brief Adds two values, where the result replaces the left operand in the place it was read from
+ * 
+ * Unlike operation_add(), an array stored in that place only is appended to in place.
+ * 
+ * @param left left operand
+ * @param right right operand
+ * @param line line in the source code used for error reporting
+ * @return value_t result of the addition
+ */
+value_t operation_add_assign(value_t left, value_t right, int line);
+
+/**
+ * @brief Subtracts two values (numbers, removal of trailing array elements or removal of a map key)
+ * 
+ * @param left left operand
+ * @param right right operand
+ * @param line line in the source code used for error reporting
+ * @return value_t result of the subtraction
+ */
+value_t operation_sub(value_t left, value_t right, int line);
+
+/**
+ * @brief Subtracts two values, where the result replaces the left operand in the place it was read from
+ * 
+ * Unlike operation_sub(), an array or map stored in that place only is shrunk in place.
+ * 
+ * @param left left operand
+ * @param right right operand
+ * @param line line in the source code used for error reporting
+ * @return value_t result of the subtraction
+ */
+value_t operation_sub_assign(value_t left, value_t right, int line);
+
+/**
+ * @brief Divides two numbers
+ * 
+ * @param left dividend
+ * @param right divisor
+ * @param line line in the source code used for error reporting
+ * @return value_t result of the division
+ */
+value_t operation_div(value_t left, value_t right, int line);
+
+/**
+ * @brief Divides two numbers and floors the result
+ * 
+ * @param left dividend
+ * @param right divisor
+ * @param line line in the source code used for error reporting
+ * @return value_t floored result of the division
+ */
+value_t operation_div_floor(value_t left, value_t right, int line);
+
+/**
+ * @brief Negates a number or a boolean
+ * 
+ * @param value value to negate
+ * @param line line in the source code used for error reporting
+ * @return value_t negated value
+ */
+value_t operation_neg(value_t value, int line);
+
+/**
+ * @brief Compares two values of the same datatype for equality
+ * 
+ * @param left left operand
+ * @param right right operand
+ * @param line line in the source code used for error reporting
+ * @return value_t boolean result of the comparison
+ */
+value_t operation_cmp_eq(value_t left, value_t right, int line);
+
+/**
+ * @brief Compares two values of the same datatype for inequality
+ * 
+ * @param left left operand
+ * @param right right operand
+ * @param line line in the source code used for error reporting
+ * @return value_t boolean result of the comparison
+ */
+value_t operation_cmp_ne(value_t left, value_t right, int line);
+
+/**
+ * @brief Creates a new array from a sequence of values
+ * 
+ * @param elements pointer to the first element
+ * @param count number of elements
+ * @return value_t created array
+ */
+value_t operation_array_def(value_t* elements, int count);
+
+/**
+ * @brief Creates a new map from a sequence of alternating keys and values
+ * 
+ * @param elements pointer to the first key
+ * @param count number of entries (key and value pairs)
+ * @param line line in the source code used for error reporting
+ * @return value_t created map
+ */
+value_t operation_map_def(value_t* elements, int count, int line);
+
+/**
+ * @brief Copies an array or a map stored in several places, so that the place it is stored back to can mutate it
+ * 
+ * @param value value read from the place
+ * @return value_t copy of a shared array or map, the value itself otherwise
+ */
+value_t operation_separate(value_t value);
+
+/**
+ * @brief Retrieves an element of an array, the value of a map key or a character of a string
+ * 
+ * @param array array, map or string to index
+ * @param index numeric index or map key
+ * @param line line in the source code used for error reporting
+ * @return value_t retrieved element
+ */
+value_t operation_array_get(value_t array, value_t index, int line);
+
+/**
+ * @brief Retrieves an element of an array or map about to be mutated, replacing a shared element by its copy
+ * 
+ * @param array array or map to index, which must not be shared
+ * @param index numeric index or map key
+ * @param line line in the source code used for error reporting
+ * @return value_t retrieved element
+ */
+value_t operation_array_get_separate(value_t array, value_t index, int line);
+
+/**
+ * @brief Stores an element into an array or the value of a key into a map
+ * 
+ * @param array array or map to store the element to
+ * @param index numeric index or map key
+ * @param value value to store
+ * @param line line in the source code used for error reporting
+ */
+void operation_array_set(value_t array, value_t index, value_t value, int line);
+
+/**
+ * @brief Retrieves the characters of a string between two indices
+ * 
+ * @param string string to slice
+ * @param start numeric index of the first character
+ * @param end numeric index past the last character
+ * @param line line in the source code used for error reporting
+ * @return value_t string sharing the characters of the sliced string
+ */
+value_t operation_slice(value_t string, value_t start, value_t end, int line);
+
+/**
+ * @brief Retrieves the size of a string, an array or a map
+ * 
+ * @param value string, array or map
+ * @param line line in the source code used for error reporting
+ * @return value_t numeric size
+ */
+value_t operation_sizeof(value_t value, int line);
+
+/**
+ * @brief Retrieves an object property or an enum item
+ * 
+ * @param value object or enum
+ * @param identifier string identifier of the property or item
+ * @param cache inline cache of the property access site
+ * @param line line in the source code used for error reporting
+ * @return value_t retrieved property or item
+ */
+value_t operation_load_prop(value_t value, value_t identifier, inline_cache_t* cache, int line);
+
+/**
+ * @brief Stores an object property, adding it to the object if it does not exist yet
+ * 
+ * @param object object to store the property to
+ * @param identifier string identifier of the property
+ * @param value value to store
+ * @param cache inline cache of the property access site
+ * @param line line in the source code used for error reporting
+ */
+void operation_store_prop(value_t object, value_t identifier, value_t value, inline_cache_t* cache, int line);
+
+/**
+ * @brief Retrieves an object property about to be mutated, replacing a shared array property by its copy
+ * 
+ * @param object object to retrieve the property from
+ * @param identifier string identifier of the property
+ * @param cache inline cache of the property access site
+ * @param line line in the source code used for error reporting
+ * @return value_t retrieved property
+ */
+value_t operation_load_prop_separate(value_t object, value_t identifier, inline_cache_t* cache, int line);
+
+/**
+ * @brief Prints a value to the standard output
+ * 
+ * @param value value to print
+ */
+void operation_print(value_t value);
+
+#endif
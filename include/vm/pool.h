@@ -11,6 +11,9 @@ typedef struct {
     uint16_t count;
     uint16_t capacity;
     value_t* values;
+
+    // string constant -> index of its pool entry
+    table_t* strings;
 } pool_t;
 
 /**
@@ -24,6 +27,8 @@ pool_t* pool_init(uint16_t initial_capacity);
 /**
  * @brief Adds a new value to the constant pool
  * 
+ * String constants must be interned, an equal string already in the pool is reused.
+ * 
  * @param pool constant pool object to add the new value to
  * @param value value to add to the constant pool object
  * @return uint16_t index of the added value in the constant pool
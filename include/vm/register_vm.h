@@ -0,0 +1,193 @@
+#ifndef gen_lang_register_vm_h
+#define gen_lang_register_vm_h
+
+#include <stdbool.h>
+
+#include "compiler/bytecode.h"
+#include "compiler/compiler.h"
+#include "utils/common.h"
+#include "utils/shape.h"
+#include "pool.h"
+#include "output.h"
+
+#define REGISTER_CODE_INITIAL_SIZE 64
+#define REGISTER_FILE_SIZE 65536
+#define REGISTER_CALL_STACK_SIZE 256
+
+/**
+ * @brief Register instruction types
+ * 
+ * Operands described as RK hold a frame register index when non-negative and
+ * a constant pool index k encoded as -(k + 1) when negative. Operands described as
+ * property(i) index the inline cache of the access site, and through it its property name.
+ * 
+ * The assigning instructions (REG_SEPARATE, REG_ADD_ASSIGN and REG_SUB_ASSIGN) only have
+ * a equal to b when they write their result directly into the local variable they read,
+ * in which case they store it like REG_STORE_LOCAL.
+ * 
+ */
+typedef enum {
+    REG_MOVE,                   // a = RK(b)
+    REG_STORE_LOCAL,            // a = RK(b), where a is a local variable
+    REG_LOAD_GLOBAL,            // a = globals[b]
+    REG_STORE_GLOBAL,           // globals[a] = RK(b)
+
+    REG_FUNC_DEF,               // globals[a] = function with bytecode entry ip b
+    REG_CALL,                   // a = a(a + 1, ..., a + b)
+    REG_CALL_DIRECT,            // a = globals[c](a, ..., a + b - 1)
+    REG_RETURN,                 // return RK(a)
+
+    REG_ENUM_DEF,               // globals[a] = enum of the b following REG_ENUM_ITEM instructions
+    REG_ENUM_ITEM,              // enum item with the identifier constant a
+
+    REG_NEW_OBJ,                // a = new object b (runs the object body with a as its register 0)
+    REG_CLONE_OBJ,              // a = new object b (clones the prototype of object b)
+    REG_OBJ_END,                // return from an object body
+    REG_LOAD_PROP,              // a = RK(b).property(c)
+    REG_LOAD_PROP_SEPARATE,     // a = RK(b).property(c), separated from its other owners
+    REG_STORE_PROP,             // RK(a).property(b) = RK(c)
+
+    REG_ARRAY_DEF,              // a = [a, ..., a + b - 1]
+    REG_ARRAY_GET,              // a = RK(b)[RK(c)]
+    REG_ARRAY_GET_SEPARATE,     // a = RK(b)[RK(c)], separated from its other owners
+    REG_ARRAY_SET,              // RK(a)[RK(b)] = RK(c)
+    REG_SEPARATE,               // a = RK(b), separated from its other owners
+    REG_SLICE,                  // a = a[a + 1 : a + 2]
+    REG_MAP_DEF,                // a = {a: a + 1, ..., a + 2b - 2: a + 2b - 1}
+
+    REG_SIZEOF,                 // a = |RK(b)|
+
+    REG_JUMP,                   // pc = a
+    REG_JUMP_IF_FALSE,          // if (!RK(b)) pc = a
+    REG_JUMP_IF_NOT_EQ,         // if (!(RK(b) == RK(c))) pc = a
+    REG_JUMP_IF_NOT_NE,         // if (!(RK(b) != RK(c))) pc = a
+    REG_JUMP_IF_NOT_LT,         // if (!(RK(b) < RK(c))) pc = a
+    REG_JUMP_IF_NOT_LE,         // if (!(RK(b) <= RK(c))) pc = a
+    REG_JUMP_IF_NOT_GT,         // if (!(RK(b) > RK(c))) pc = a
+    REG_JUMP_IF_NOT_GE,         // if (!(RK(b) >= RK(c))) pc = a
+
+    REG_ADD,                    // a = RK(b) + RK(c)
+    REG_SUB,                    // a = RK(b) - RK(c)
+    REG_ADD_ASSIGN,             // a = RK(b) + RK(c), where the result replaces RK(b)
+    REG_SUB_ASSIGN,             // a = RK(b) - RK(c), where the result replaces RK(b)
+    REG_MUL,                    // a = RK(b) * RK(c)
+    REG_DIV,                    // a = RK(b) / RK(c)
+    REG_DIV_FLOOR,              // a = RK(b) // RK(c)
+    REG_NEG,                    // a = -RK(b)
+
+    REG_CMP_EQ,                 // a = RK(b) == RK(c)
+    REG_CMP_NE,                 // a = RK(b) != RK(c)
+    REG_CMP_LT,                 // a = RK(b) < RK(c)
+    REG_CMP_LE,                 // a = RK(b) <= RK(c)
+    REG_CMP_GT,                 // a = RK(b) > RK(c)
+    REG_CMP_GE,                 // a = RK(b) >= RK(c)
+
+    REG_AND,                    // a = RK(b) and RK(c)
+    REG_OR,                     // a = RK(b) or RK(c)
+
+    REG_PRINT,                  // print RK(a)
+    REG_ENDL,                   // print newline
+
+    REG_HALT,                   // stop the virtual machine
+
+    REG_NUM_INSTRUCTIONS,
+} register_op_code_t;
+
+/**
+ * @brief Object representing a three-address register instruction
+ * 
+ */
+typedef struct {
+    byte_t op;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+} register_instruction_t;
+
+/**
+ * @brief Object representing the array of register instructions and their corresponding line numbers
+ * 
+ */
+typedef struct {
+    int count;
+    int capacity;
+    register_instruction_t* instructions;
+    int* lines;
+} register_code_t;
+
+/**
+ * @brief Object representing a translated function or object body
+ * 
+ */
+typedef struct {
+    int entry;
+    int param_count;
+    int local_count;
+    int frame_size;
+} register_function_t;
+
+/**
+ * @brief Object representing a register call frame
+ * 
+ */
+typedef struct {
+    register_instruction_t* return_pc;
+    value_t* registers;
+    value_t* registers_top;
+    value_t* result;
+} register_frame_t;
+
+/**
+ * @brief Object representing a register-based virtual machine
+ * 
+ */
+typedef struct {
+    register_code_t* code;
+
+    register_function_t* functions;
+    int function_count;
+    int function_capacity;
+
+    // bytecode entry ip of a function -> index of its translated function (-1 if none)
+    int* function_by_ip;
+    // object declaration index -> index of its translated body
+    int* objects;
+    int object_count;
+
+    // prototypes cloned by new for object declarations with literal initializers only
+    object_template_t* templates;
+
+    value_t* globals;
+    int global_count;
+
+    // inline caches of the property access sites and the constant pool indices of their property names
+    inline_cache_t* caches;
+    int* cache_identifiers;
+
+    // registers below registers_top belong to active frames and are scanned by the garbage collector
+    value_t* registers;
+    value_t* registers_top;
+    int top_level_frame_size;
+
+    register_frame_t frames[REGISTER_CALL_STACK_SIZE];
+    register_frame_t* frame_top;
+
+    pool_t* pool;
+} register_virtual_machine_t;
+
+/**
+ * @brief Translates the stack bytecode into register instructions and initializes the register virtual machine
+ * 
+ * @param bytecode bytecode object to translate
+ */
+void register_vm_init(bytecode_t* bytecode);
+
+/**
+ * @brief Starts the register virtual machine and interprets the translated instructions
+ * 
+ */
+void register_vm_run(bool test);
+
+output_t* register_vm_get_output();
+
+#endif
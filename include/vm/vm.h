@@ -4,24 +4,40 @@
 #include <stdbool.h>
 
 #include "compiler/bytecode.h"
+#include "compiler/compiler.h"
 #include "utils/common.h"
+#include "utils/shape.h"
 #include "callstack.h"
 #include "pool.h"
 #include "output.h"
 
+#define VALUE_STACK_SIZE 65536
+
 /**
  * @brief Object representing a virtual machine
  * 
  */
 typedef struct {
     long ip;
-    value_t stack[256];
-    value_t* stack_top;
     bytecode_t* bytecode;
 
-    table_t* var_table;
-    table_t* func_table;
-    table_t* obj_table;
+    // operand stack holding the locals windows of all active function calls
+    value_t* stack;
+    value_t* stack_top;
+
+    // locals window of the running function
+    value_t* locals;
+
+    value_t* globals;
+    int global_count;
+    long* objects;
+    int object_count;
+
+    // prototypes cloned by new for object declarations with literal initializers only
+    object_template_t* templates;
+
+    // inline caches of the property access sites, indexed by the operand of the access instruction
+    inline_cache_t* caches;
 
     call_stack_t* call_stack;
     pool_t* pool;
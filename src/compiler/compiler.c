@@ -11,6 +11,9 @@
 #include "compiler/stack.h"
 #include "utils/error.h"
 #include "utils/common.h"
+#include "utils/memory.h"
+#include "utils/shape.h"
+#include "vm/natives.h"
 
 static bool DEBUG = false;
 
@@ -20,12 +23,57 @@ static void emit(byte_t instruction, int line) {
     bytecode_add(compiler.bytecode, instruction, line);
 }
 
+static void emit_uint16(uint16_t value, int line) {
+    byte_t* bytes = uint16_to_bytes(value);
+
+    emit(bytes[0], line);
+    emit(bytes[1], line);
+
+    free(bytes);
+}
+
+static void emit_uint32(uint32_t value, int line) {
+    byte_t* bytes = uint32_to_bytes(value);
+
+    for (int i = 0; i < 4; i++) {
+        emit(bytes[i], line);
+    }
+
+    free(bytes);
+}
+
+static void patch_uint32(int ip, uint32_t value) {
+    byte_t* bytes = uint32_to_bytes(value);
+
+    for (int i = 0; i < 4; i++) {
+        compiler.bytecode->instructions[ip + i] = bytes[i];
+    }
+
+    free(bytes);
+}
+
+static int emit_jump(byte_t instruction, uint32_t jump_ip, int line) {
+    int ip = compiler.bytecode->count;
+
+    emit(instruction, line);
+    emit_uint32(jump_ip, line);
+
+    return ip;
+}
+
+static void patch_uint16(int ip, uint16_t value) {
+    byte_t* bytes = uint16_to_bytes(value);
+
+    compiler.bytecode->instructions[ip] = bytes[0];
+    compiler.bytecode->instructions[ip + 1] = bytes[1];
+
+    free(bytes);
+}
+
 static void emit_numeric_literal(char* raw_value, int line) {
     emit(OP_LOAD_CONST, line);
 
-    value_t value;
-    value.type = TYPE_NUMBER;
-    value.as.number = atof(raw_value);
+    value_t value = NUMBER_VALUE(atof(raw_value));
 
     uint16_t value_index = pool_add(compiler.pool, value);
     byte_t* bytes = uint16_to_bytes(value_index);
@@ -39,9 +87,7 @@ static void emit_numeric_literal(char* raw_value, int line) {
 static void emit_numeric_literal_num(double numeric_value, int line) {
     emit(OP_LOAD_CONST, line);
 
-    value_t value;
-    value.type = TYPE_NUMBER;
-    value.as.number = numeric_value;
+    value_t value = NUMBER_VALUE(numeric_value);
 
     uint16_t value_index = pool_add(compiler.pool, value);
     byte_t* bytes = uint16_to_bytes(value_index);
@@ -55,9 +101,7 @@ static void emit_numeric_literal_num(double numeric_value, int line) {
 static void emit_boolean_literal(char* raw_value, int line) {
     emit(OP_LOAD_CONST, line);
 
-    value_t value;
-    value.type = TYPE_BOOLEAN;
-    value.as.boolean = strcmp(raw_value, "true") == 0;
+    value_t value = BOOLEAN_VALUE(strcmp(raw_value, "true") == 0);
 
     uint16_t value_index = pool_add(compiler.pool, value);
     byte_t* bytes = uint16_to_bytes(value_index);
@@ -68,12 +112,21 @@ static void emit_boolean_literal(char* raw_value, int line) {
     free(bytes);
 }
 
-static void emit_string_literal(char* raw_value, int line) {
+// property accesses carry the index of their own inline cache
+static void emit_property_access(byte_t instruction, int line) {
+    if (compiler.cache_count > UINT16_MAX) {
+        error_throw(ERROR_COMPILER, "Too many property accesses in program", line);
+    }
+
+    emit(instruction, line);
+    emit_uint16((uint16_t)compiler.cache_count++, line);
+}
+
+static void emit_string_literal(const char* start, int length, int line) {
     emit(OP_LOAD_CONST, line);
 
-    value_t value;
-    value.type = TYPE_STRING;
-    value.as.string = raw_value;
+    // string constants are interned, so every occurrence of a literal shares one pool entry
+    value_t value = STRING_VALUE(memory_intern_string(start, length));
 
     uint16_t value_index = pool_add(compiler.pool, value);
     byte_t* bytes = uint16_to_bytes(value_index);
@@ -84,42 +137,16 @@ static void emit_string_literal(char* raw_value, int line) {
     free(bytes);
 }
 
-static double get_main_func_ip() {
-    for (int i = 0; i < compiler.bytecode->count; i++) {
-        if (compiler.bytecode->instructions[i] == OP_LOAD_CONST) {
-            i++;
-
-            byte_t bytes[2];
-            for (int j = 0; j < 2; j++) {
-                bytes[j] = compiler.bytecode->instructions[i + j];
-            }
-
-            i += 2;
-
-            uint16_t index = bytes_to_uint16(bytes);
-            value_t* value = pool_get(compiler.pool, index);
-
-            if (value == NULL) {
-                continue;
-            }
-
-            if (value->type == TYPE_STRING && strcmp(value->as.string, "main") == 0 && compiler.bytecode->instructions[i] == OP_FUNC_DEF) {
-                return (double)(i + 1);
-            }
+static void emit_main_func_call() {
+    int main_index = symbol_table_find(compiler.globals, memory_intern_string("main", 4));
 
-            i -= 1;
-        }
+    if (main_index == -1 || !compiler.globals->symbols[main_index].declared) {
+        error_throw(ERROR_COMPILER, "main() function is missing", 0);
     }
 
-    error_throw(ERROR_COMPILER, "main() function is missing", 0);
-    return 0;
-}
-
-static void emit_main_func_call() {
-    double main_func_ip = get_main_func_ip();
-    emit_numeric_literal_num(main_func_ip, 0);
-    emit_numeric_literal_num(0, 0);
-    emit(OP_CALL, 0);
+    emit(OP_CALL_DIRECT, 0);
+    emit_uint16((uint16_t)main_index, 0);
+    emit(0, 0);
 }
 
 static void compile_var_declaration();
@@ -128,10 +155,12 @@ static void compile_func_declaration_param_list();
 static void compile_func_declaration_body();
 static void compile_enum_declaration();
 static void compile_enum_declaration_body();
+static void ensure_templates(int count);
 static void compile_object_declaration();
-static void compile_object_declaration_body();
-static void compile_object_declaration_property();
+static void compile_object_declaration_body(object_template_t* template);
+static void compile_object_declaration_property(object_template_t* template);
 static void compile_array_instantiation_expression();
+static void compile_map_instantiation_expression();
 static void compile_conditional_statement(stack_long_t* break_stack);
 static void compile_conditional_statement_body(stack_long_t* break_stack);
 static void compile_while_statement();
@@ -151,7 +180,8 @@ static void compile_multiplicative_expression();
 static void compile_sizeof_expression();
 static void compile_access();
 static void compile_call_expression();
-static double compile_call_expression_args();
+static void compile_direct_call_expression(token_t identifier_token);
+static int compile_call_expression_args();
 static void compile_primary_expression();
 static void compile_identifier();
 static void compile_numeric_literal();
@@ -184,10 +214,125 @@ static token_t assert(token_type type) {
     return token;
 }
 
+// identifiers are interned, so symbol and property lookups can match them by pointer
+static inline char* intern_identifier(token_t identifier_token) {
+    return memory_intern_string(identifier_token.start, identifier_token.length);
+}
+
+// LOCAL VARIABLES
+
+static int resolve_local(token_t identifier_token) {
+    if (compiler.locals == NULL) {
+        return -1;
+    }
+
+    char* identifier = intern_identifier(identifier_token);
+    value_t* slot = table_get(compiler.locals, identifier);
+
+    return slot == NULL ? -1 : (int)AS_NUMBER(*slot);
+}
+
+static int declare_local(token_t identifier_token) {
+    int slot = resolve_local(identifier_token);
+
+    // redeclaration within the same function reuses the slot
+    if (slot != -1) {
+        return slot;
+    }
+
+    if (compiler.local_count == LOCALS_MAX) {
+        error_throw(ERROR_COMPILER, "Too many local variables in function", identifier_token.line);
+    }
+
+    value_t value = NUMBER_VALUE(compiler.local_count);
+
+    char* identifier = intern_identifier(identifier_token);
+    table_set(compiler.locals, identifier, value);
+
+    return compiler.local_count++;
+}
+
+// GLOBAL VARIABLES
+
+static int resolve_global(token_t identifier_token) {
+    char* identifier = intern_identifier(identifier_token);
+    int index = symbol_table_resolve(compiler.globals, identifier, identifier_token.line);
+
+    return index;
+}
+
+static int declare_global(token_t identifier_token) {
+    char* identifier = intern_identifier(identifier_token);
+    int index = symbol_table_declare(compiler.globals, identifier, identifier_token.line);
+
+    return index;
+}
+
+static int resolve_object(token_t identifier_token) {
+    char* identifier = intern_identifier(identifier_token);
+    int index = symbol_table_resolve(compiler.objects, identifier, identifier_token.line);
+
+    return index;
+}
+
+static int declare_object(token_t identifier_token) {
+    char* identifier = intern_identifier(identifier_token);
+    int index = symbol_table_declare(compiler.objects, identifier, identifier_token.line);
+
+    return index;
+}
+
+static void emit_load_identifier(token_t identifier_token) {
+    int slot = resolve_local(identifier_token);
+
+    if (slot != -1) {
+        emit(OP_LOAD_LOCAL, identifier_token.line);
+        emit_uint16((uint16_t)slot, identifier_token.line);
+        return;
+    }
+
+    emit(OP_LOAD_GLOBAL, identifier_token.line);
+    emit_uint16((uint16_t)resolve_global(identifier_token), identifier_token.line);
+}
+
+static void emit_store_identifier(token_t identifier_token) {
+    int slot = resolve_local(identifier_token);
+
+    if (slot != -1) {
+        emit(OP_STORE_LOCAL, identifier_token.line);
+        emit_uint16((uint16_t)slot, identifier_token.line);
+        return;
+    }
+
+    emit(OP_STORE_GLOBAL, identifier_token.line);
+    emit_uint16((uint16_t)resolve_global(identifier_token), identifier_token.line);
+}
+
 pool_t* compiler_get_pool() {
     return compiler.pool;
 }
 
+int compiler_get_global_count() {
+    return compiler.globals->count;
+}
+
+int compiler_get_native_count() {
+    return compiler.native_count;
+}
+
+int compiler_get_object_count() {
+    return compiler.objects->count;
+}
+
+int compiler_get_cache_count() {
+    return compiler.cache_count;
+}
+
+object_template_t* compiler_get_templates() {
+    ensure_templates(compiler.objects->count + 1);
+    return compiler.templates;
+}
+
 compiler_t* compiler_init(const char* source_code) {
     lexer_init(source_code);
 
@@ -197,6 +342,25 @@ compiler_t* compiler_init(const char* source_code) {
     compiler_instance->current_token = lexer_get_token();
     compiler_instance->pool = pool_init(50);
     compiler_instance->continue_stack = stack_long_init();
+    compiler_instance->locals = NULL;
+    compiler_instance->local_count = 0;
+    compiler_instance->globals = symbol_table_init();
+    compiler_instance->objects = symbol_table_init();
+
+    // natives take the first global slots, where the virtual machines install them
+    compiler_instance->native_count = natives_count();
+
+    for (int i = 0; i < compiler_instance->native_count; i++) {
+        const char* name = natives_get(i)->name;
+        symbol_table_declare(compiler_instance->globals, memory_intern_string(name, strlen(name)), 0);
+    }
+
+    compiler_instance->cache_count = 0;
+    compiler_instance->update_ip = -1;
+    compiler_instance->update_operand_start = -1;
+    compiler_instance->update_operand_end = -1;
+    compiler_instance->templates = NULL;
+    compiler_instance->template_capacity = 0;
 
     return compiler_instance;
 }
@@ -226,6 +390,21 @@ bytecode_t* compile(compiler_t* compiler_instance) {
     }
 
     emit_main_func_call();
+
+    symbol_t* undeclared_global = symbol_table_undeclared(compiler.globals);
+
+    if (undeclared_global != NULL) {
+        error_throw(ERROR_COMPILER, "Variable with the given identifier does not exist", undeclared_global->line);
+        return NULL;
+    }
+
+    symbol_t* undeclared_object = symbol_table_undeclared(compiler.objects);
+
+    if (undeclared_object != NULL) {
+        error_throw(ERROR_COMPILER, "Object with the given identifier does not exist", undeclared_object->line);
+        return NULL;
+    }
+
     return compiler.bytecode;
 }
 
@@ -244,8 +423,17 @@ static void compile_var_declaration() {
 
     assert(TOKEN_SEMICOLON);
 
-    emit_string_literal(substring(identifier_token.start, identifier_token.length), line);
-    emit(OP_DECLARE_VAR, line);
+    // local variable
+    if (compiler.locals != NULL) {
+        int slot = declare_local(identifier_token);
+        emit(OP_STORE_LOCAL, line);
+        emit_uint16((uint16_t)slot, line);
+        return;
+    }
+
+    // global variable
+    emit(OP_STORE_GLOBAL, line);
+    emit_uint16((uint16_t)declare_global(identifier_token), line);
 }
 
 static void compile_func_declaration() {
@@ -254,13 +442,26 @@ static void compile_func_declaration() {
     int line = assert(TOKEN_FUNC).line;
     token_t identifier_token = assert(TOKEN_IDENTIFIER);
 
-    emit_string_literal(substring(identifier_token.start, identifier_token.length), line);
     emit(OP_FUNC_DEF, line);
+    emit_uint16((uint16_t)declare_global(identifier_token), line);
+
+    // dummy end ip 0, param count 0 and local count 0
+    int end_ip = compiler.bytecode->count;
+    emit_uint32(0, line);
+    int param_count_ip = compiler.bytecode->count;
+    emit(0, line);
+    int local_count_ip = compiler.bytecode->count;
+    emit_uint16(0, line);
+
+    compiler.locals = table_init(50);
+    compiler.local_count = 0;
 
     assert(TOKEN_OPEN_PAREN);
     compile_func_declaration_param_list();
     assert(TOKEN_CLOSE_PAREN);
 
+    compiler.bytecode->instructions[param_count_ip] = (byte_t)compiler.local_count;
+
     assert(TOKEN_OPEN_BRACE);
     compile_func_declaration_body();
     line = assert(TOKEN_CLOSE_BRACE).line;
@@ -270,6 +471,13 @@ static void compile_func_declaration() {
     emit(OP_RETURN, line);
 
     emit(OP_FUNC_END, line);
+
+    patch_uint32(end_ip, (uint32_t)compiler.bytecode->count);
+    patch_uint16(local_count_ip, (uint16_t)compiler.local_count);
+
+    table_free(compiler.locals);
+    free(compiler.locals);
+    compiler.locals = NULL;
 }
 
 static void compile_func_declaration_param_list() {
@@ -279,8 +487,16 @@ static void compile_func_declaration_param_list() {
         int line = assert(TOKEN_VAR).line;
         token_t identifier_token = assert(TOKEN_IDENTIFIER);
 
-        emit_string_literal(substring(identifier_token.start, identifier_token.length), line);
-        emit(OP_DECLARE_VAR, line);
+        if (resolve_local(identifier_token) != -1) {
+            error_throw(ERROR_COMPILER, "Duplicate parameter identifier", line);
+        }
+
+        if (compiler.local_count == UINT8_MAX) {
+            error_throw(ERROR_COMPILER, "Too many function parameters", line);
+        }
+
+        // arguments are passed in the first local slots, in declaration order
+        declare_local(identifier_token);
 
         if (peek().type == TOKEN_COMMA) {
             advance();
@@ -331,8 +547,8 @@ static void compile_enum_declaration() {
     int line = assert(TOKEN_ENUM).line;
     token_t identifier_token = assert(TOKEN_IDENTIFIER);
     
-    emit_string_literal(substring(identifier_token.start, identifier_token.length), line);
     emit(OP_ENUM_DEF, line);
+    emit_uint16((uint16_t)declare_global(identifier_token), line);
 
     assert(TOKEN_OPEN_BRACE);
     compile_enum_declaration_body();
@@ -346,7 +562,7 @@ static void compile_enum_declaration_body() {
     while (peek().type != TOKEN_CLOSE_BRACE) {
         token_t identifier_token = assert(TOKEN_IDENTIFIER);
 
-        emit_string_literal(substring(identifier_token.start, identifier_token.length), identifier_token.line);
+        emit_string_literal(identifier_token.start, identifier_token.length, identifier_token.line);
         emit(OP_STORE_ENUM, identifier_token.line);
 
         if (peek().type == TOKEN_COMMA) {
@@ -355,28 +571,80 @@ static void compile_enum_declaration_body() {
     }
 }
 
+static void ensure_templates(int count) {
+    if (count <= compiler.template_capacity) {
+        return;
+    }
+
+    int capacity = compiler.template_capacity == 0 ? 16 : compiler.template_capacity;
+
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    compiler.templates = (object_template_t*)realloc(compiler.templates, capacity * sizeof(object_template_t));
+
+    if (compiler.templates == NULL) {
+        error_throw(ERROR_COMPILER, "Failed to allocate memory for object templates", 0);
+    }
+
+    memset(compiler.templates + compiler.template_capacity, 0, (capacity - compiler.template_capacity) * sizeof(object_template_t));
+    compiler.template_capacity = capacity;
+}
+
+static void add_template_property(object_template_t* template, token_t identifier_token, value_t value) {
+    char* identifier = intern_identifier(identifier_token);
+    int slot = shape_lookup(template->shape, identifier);
+
+    if (slot == -1) {
+        template->shape = shape_transition(template->shape, identifier);
+        template->slots = (value_t*)realloc(template->slots, template->shape->count * sizeof(value_t));
+        slot = template->shape->count - 1;
+    }
+
+    template->slots[slot] = value;
+}
+
+static void discard_template(object_template_t* template) {
+    free(template->slots);
+    template->shape = NULL;
+    template->slots = NULL;
+}
+
 static void compile_object_declaration() {
     if (DEBUG == true) printf("Compiling compile_object_declaration\n");
 
     int line = assert(TOKEN_OBJECT).line;
     token_t identifier_token = assert(TOKEN_IDENTIFIER);
+    int index = declare_object(identifier_token);
 
-    emit_string_literal(substring(identifier_token.start, identifier_token.length), line);
     emit(OP_OBJ_DEF, line);
+    emit_uint16((uint16_t)index, line);
+
+    // dummy end ip 0
+    int end_ip = compiler.bytecode->count;
+    emit_uint32(0, line);
+
+    object_template_t template = { .shape = shape_root(), .slots = NULL };
 
     assert(TOKEN_OPEN_BRACE);
-    compile_object_declaration_body();
+    compile_object_declaration_body(&template);
     line = assert(TOKEN_CLOSE_BRACE).line;
     emit(OP_OBJ_END, line);
+
+    patch_uint32(end_ip, (uint32_t)compiler.bytecode->count);
+
+    ensure_templates(index + 1);
+    compiler.templates[index] = template;
 }
 
-static void compile_object_declaration_body() {
+static void compile_object_declaration_body(object_template_t* template) {
     if (DEBUG == true) printf("Compiling compile_object_declaration_body\n");
 
     while (peek().type != TOKEN_CLOSE_BRACE) {
         switch (peek().type) {
             case TOKEN_VAR: {
-                compile_object_declaration_property();
+                compile_object_declaration_property(template);
                 break;
             }
             default: {
@@ -387,11 +655,12 @@ static void compile_object_declaration_body() {
     }
 }
 
-static void compile_object_declaration_property() {
+static void compile_object_declaration_property(object_template_t* template) {
     if (DEBUG == true) printf("Compiling compile_object_declaration_property\n");
 
     int line = assert(TOKEN_VAR).line;
     token_t identifier_token = assert(TOKEN_IDENTIFIER);
+    int start = compiler.bytecode->count;
 
     if (peek().type == TOKEN_SEMICOLON) {
         emit_numeric_literal_num(0, identifier_token.line);
@@ -402,23 +671,23 @@ static void compile_object_declaration_property() {
 
     assert(TOKEN_SEMICOLON);
 
-    emit_string_literal(substring(identifier_token.start, identifier_token.length), line);
-    emit(OP_INIT_PROP, line);
-}
+    // only literal initializers can be shared by every instance of the object
+    if (template->shape != NULL) {
+        byte_t* instructions = compiler.bytecode->instructions;
 
-static inline void update_jump_values(int source_ip, int jump_ip) {
-    value_t value;
-    value.type = TYPE_NUMBER;
-    value.as.number = jump_ip;
+        if (compiler.bytecode->count - start == 1 + instruction_operand_size(OP_LOAD_CONST) && instructions[start] == OP_LOAD_CONST) {
+            add_template_property(template, identifier_token, compiler.pool->values[bytes_to_uint16(&instructions[start + 1])]);
+        } else {
+            discard_template(template);
+        }
+    }
 
-    // TODO: don't store jump ips into constant pool, rather a separate pool
-    uint16_t value_index = pool_add(compiler.pool, value);
-    
-    byte_t* bytes = uint16_to_bytes(value_index);
-    compiler.bytecode->instructions[source_ip + 1] = bytes[0];
-    compiler.bytecode->instructions[source_ip + 2] = bytes[1];
+    emit_string_literal(identifier_token.start, identifier_token.length, line);
+    emit_property_access(OP_INIT_PROP, line);
+}
 
-    free(bytes);
+static inline void update_jump_values(int source_ip, int jump_ip) {
+    patch_uint32(source_ip + 1, (uint32_t)jump_ip);
 }
 
 static void compile_conditional_statement(stack_long_t* break_stack) {
@@ -428,10 +697,8 @@ static void compile_conditional_statement(stack_long_t* break_stack) {
     assert(TOKEN_OPEN_PAREN);
     compile_expression();
 
-    int ip1 = compiler.bytecode->count;
     // dummy value 0
-    emit_numeric_literal_num(0, line);
-    emit(OP_JUMP_IF_FALSE, line);
+    int ip1 = emit_jump(OP_JUMP_IF_FALSE, 0, line);
 
     assert(TOKEN_CLOSE_PAREN);
     assert(TOKEN_OPEN_BRACE);
@@ -446,10 +713,8 @@ static void compile_conditional_statement(stack_long_t* break_stack) {
         return;
     }
 
-    int ip3 = compiler.bytecode->count;
     // dummy value 0
-    emit_numeric_literal_num(0, line);
-    emit(OP_JUMP, line);
+    int ip3 = emit_jump(OP_JUMP, 0, line);
 
     int ip4 = compiler.bytecode->count;
     update_jump_values(ip1, ip4);
@@ -521,11 +786,8 @@ static void compile_while_statement() {
 
     compile_expression();
 
-    int ip2 = compiler.bytecode->count;
-
     // dummy value 0
-    emit_numeric_literal_num(0, line);
-    emit(OP_JUMP_IF_FALSE, line);
+    int ip2 = emit_jump(OP_JUMP_IF_FALSE, 0, line);
 
     assert(TOKEN_CLOSE_PAREN);
     assert(TOKEN_OPEN_BRACE);
@@ -536,8 +798,7 @@ static void compile_while_statement() {
 
     line = assert(TOKEN_CLOSE_BRACE).line;
 
-    emit_numeric_literal_num((double)ip1, line);
-    emit(OP_JUMP, line);
+    emit_jump(OP_JUMP, (uint32_t)ip1, line);
 
     int ip3 = compiler.bytecode->count;
     update_jump_values(ip2, ip3);
@@ -601,8 +862,7 @@ static void compile_continue_statement() {
     int line = assert(TOKEN_CONTINUE).line;
 
     long jump_ip = stack_long_peek(compiler.continue_stack);
-    emit_numeric_literal_num((double)jump_ip, line);
-    emit(OP_JUMP, line);
+    emit_jump(OP_JUMP, (uint32_t)jump_ip, line);
 
     assert(TOKEN_SEMICOLON);
 }
@@ -612,53 +872,93 @@ static void compile_break_statement(stack_long_t* break_stack) {
 
     int line = assert(TOKEN_BREAK).line;
 
-    stack_long_push(break_stack, compiler.bytecode->count);
-
-    long jump_ip = 0;
-    emit_numeric_literal_num((double)jump_ip, line);
-    emit(OP_JUMP, line);
+    // dummy value 0
+    int ip = emit_jump(OP_JUMP, 0, line);
+    stack_long_push(break_stack, ip);
 
     assert(TOKEN_SEMICOLON);
 }
 
+// checks whether the instruction at ip loads the given variable
+static bool loads_identifier(int ip, token_t identifier_token) {
+    byte_t* instructions = compiler.bytecode->instructions;
+    int slot = resolve_local(identifier_token);
+
+    if (slot != -1) {
+        return instructions[ip] == OP_LOAD_LOCAL && bytes_to_uint16(&instructions[ip + 1]) == slot;
+    }
+
+    return instructions[ip] == OP_LOAD_GLOBAL && bytes_to_uint16(&instructions[ip + 1]) == resolve_global(identifier_token);
+}
+
+// checks whether the expression compiled from start is an addition or a subtraction whose left operand
+// spans operand_length bytes, which the caller checks to read the assignment target
+static bool is_update(int start, int operand_length) {
+    return compiler.update_ip == compiler.bytecode->count - 1
+        && compiler.update_operand_start == start
+        && compiler.update_operand_end - start == operand_length;
+}
+
+// the result of an update replaces its left operand, so an array stored in the target only can be mutated in place
+static void emit_update() {
+    byte_t* instruction = &compiler.bytecode->instructions[compiler.update_ip];
+    *instruction = *instruction == OP_ADD ? OP_ADD_ASSIGN : OP_SUB_ASSIGN;
+}
+
 static void compile_assignment_statement() {
     token_t identifier = assert(TOKEN_IDENTIFIER);
 
     // basic variable assignment
     if (peek().type == TOKEN_ASSIGNMENT) {
         assert(TOKEN_ASSIGNMENT);
+        int start = compiler.bytecode->count;
         compile_expression();
         assert(TOKEN_SEMICOLON);
 
-        emit_string_literal(substring(identifier.start, identifier.length), identifier.line);
-        emit(OP_STORE_VAR, identifier.line);
+        if (is_update(start, 1 + instruction_operand_size(OP_LOAD_LOCAL)) && loads_identifier(start, identifier)) {
+            emit_update();
+        }
+
+        emit_store_identifier(identifier);
 
         return;
     }
 
     // call statement
     if (peek().type == TOKEN_OPEN_PAREN) {
-        int line = assert(TOKEN_OPEN_PAREN).line;
-        emit_string_literal(substring(identifier.start, identifier.length), identifier.line);
-        emit(OP_LOAD_VAR, identifier.line);
+        if (resolve_local(identifier) == -1) {
+            compile_direct_call_expression(identifier);
+        } else {
+            int line = assert(TOKEN_OPEN_PAREN).line;
+            emit_load_identifier(identifier);
 
-        double arg_count = compile_call_expression_args();
-        assert(TOKEN_CLOSE_PAREN);
+            int arg_count = compile_call_expression_args();
+            assert(TOKEN_CLOSE_PAREN);
+
+            emit(OP_CALL, identifier.line);
+            emit((byte_t)arg_count, line);
+        }
 
-        emit_numeric_literal_num(arg_count, line);
-        emit(OP_CALL, identifier.line);
-        line = assert(TOKEN_SEMICOLON).line;
+        int line = assert(TOKEN_SEMICOLON).line;
 
-        emit_numeric_literal_num(1, line);
         emit(OP_STACK_CLEAR, line);
+        emit(1, line);
 
         return;
     }
 
-    emit_string_literal(substring(identifier.start, identifier.length), identifier.line);
-    emit(OP_LOAD_VAR, identifier.line);
+    // elements are only stored into arrays that are not shared, so the arrays along the target
+    // are separated from their other owners, starting with the array of an indexed variable
+    if (peek().type == TOKEN_OPEN_BRACKET) {
+        emit_load_identifier(identifier);
+        emit(OP_SEPARATE, identifier.line);
+        emit_store_identifier(identifier);
+    }
+
+    emit_load_identifier(identifier);
 
     token_t prop;
+    bool first = true;
     while (true) {
         if (peek().type == TOKEN_DOT) {
             assert(TOKEN_DOT);
@@ -666,16 +966,36 @@ static void compile_assignment_statement() {
 
             if (peek().type == TOKEN_ASSIGNMENT) {
                 assert(TOKEN_ASSIGNMENT);
+                int start = compiler.bytecode->count;
                 compile_expression();
                 assert(TOKEN_SEMICOLON);
-                emit_string_literal(substring(prop.start, prop.length), prop.line);
-                emit(OP_STORE_PROP, prop.line);
+
+                // updates of a property of a variable, such as o.p = o.p + 1, load the property as a constant property
+                int load_size = 1 + instruction_operand_size(OP_LOAD_LOCAL);
+                int name_size = 1 + instruction_operand_size(OP_LOAD_CONST);
+                int prop_size = 1 + instruction_operand_size(OP_LOAD_PROP_CONST);
+
+                if (first && is_update(start, load_size + name_size + prop_size) && loads_identifier(start, identifier)) {
+                    byte_t* instructions = &compiler.bytecode->instructions[start + load_size];
+
+                    if (instructions[0] == OP_LOAD_CONST && instructions[name_size] == OP_LOAD_PROP_CONST) {
+                        value_t name = compiler.pool->values[bytes_to_uint16(&instructions[1])];
+
+                        if (IS_STRING(name) && AS_STRING(name) == intern_identifier(prop)) {
+                            emit_update();
+                        }
+                    }
+                }
+
+                emit_string_literal(prop.start, prop.length, prop.line);
+                emit_property_access(OP_STORE_PROP, prop.line);
                 return;
             } else {
-                emit_string_literal(substring(prop.start, prop.length), prop.line);
-                emit(OP_LOAD_PROP, prop.line);
+                emit_string_literal(prop.start, prop.length, prop.line);
+                emit_property_access(OP_LOAD_PROP_SEPARATE, prop.line);
             }
 
+            first = false;
             continue;
         }
 
@@ -691,8 +1011,10 @@ static void compile_assignment_statement() {
                 emit(OP_ARRAY_SET, prop.line);
                 return;
             } else {
-                emit(OP_ARRAY_GET, prop.line);
+                emit(OP_ARRAY_GET_SEPARATE, prop.line);
             }
+
+            first = false;
         }
     }
 }
@@ -742,6 +1064,10 @@ static void compile_expression() {
             compile_array_instantiation_expression();
             break;
         }
+        case TOKEN_OPEN_BRACE: {
+            compile_map_instantiation_expression();
+            break;
+        }
         default: {
             compile_logical_expression();
             break;
@@ -753,8 +1079,8 @@ static void compile_object_instantiation_expression() {
     int line = assert(TOKEN_NEW).line;
     token_t identifier_token = assert(TOKEN_IDENTIFIER);
 
-    emit_string_literal(substring(identifier_token.start, identifier_token.length), identifier_token.line);
     emit(OP_NEW_OBJ, line);
+    emit_uint16((uint16_t)resolve_object(identifier_token), line);
 }
 
 static void compile_array_instantiation_expression() {
@@ -773,8 +1099,39 @@ static void compile_array_instantiation_expression() {
 
     assert(TOKEN_CLOSE_BRACKET);
 
-    emit_numeric_literal_num((double)count, line);
+    if (count > UINT16_MAX) {
+        error_throw(ERROR_COMPILER, "Too many elements in array literal", line);
+    }
+
     emit(OP_ARRAY_DEF, line);
+    emit_uint16((uint16_t)count, line);
+}
+
+static void compile_map_instantiation_expression() {
+    int line = assert(TOKEN_OPEN_BRACE).line;
+
+    int count = 0;
+
+    // keys and values are pushed alternately, the VM pairs them when building the map
+    while (peek().type != TOKEN_CLOSE_BRACE) {
+        compile_expression();
+        assert(TOKEN_COLON);
+        compile_expression();
+        count++;
+
+        if (peek().type == TOKEN_COMMA) {
+            advance();
+        }
+    }
+
+    assert(TOKEN_CLOSE_BRACE);
+
+    if (count > UINT16_MAX / 2) {
+        error_throw(ERROR_COMPILER, "Too many entries in map literal", line);
+    }
+
+    emit(OP_MAP_DEF, line);
+    emit_uint16((uint16_t)count, line);
 }
 
 static void compile_logical_expression() {
@@ -840,13 +1197,22 @@ static void compile_relational_operator(token_t operator_token) {
 static void compile_additive_expression() {
     if (DEBUG == true) printf("Compiling compile_additive_expression\n");
 
+    int start = compiler.bytecode->count;
     compile_multiplicative_expression();
+    int end = compiler.bytecode->count;
 
-    while (peek().type == TOKEN_PLUS || peek().type == TOKEN_MINUS) {
+    for (bool first = true; peek().type == TOKEN_PLUS || peek().type == TOKEN_MINUS; first = false) {
         token_t operator_token = advance();
 
         compile_multiplicative_expression();
         compile_binary_operator(operator_token);
+
+        // only the first operator has a left operand that may read a variable or property as a whole
+        if (first) {
+            compiler.update_ip = compiler.bytecode->count - 1;
+            compiler.update_operand_start = start;
+            compiler.update_operand_end = end;
+        }
     }
 }
 
@@ -874,13 +1240,22 @@ static void compile_access() {
                 assert(TOKEN_DOT);
                 token_t identifier = assert(TOKEN_IDENTIFIER);
 
-                emit_string_literal(substring(identifier.start, identifier.length), identifier.line);
-                emit(OP_LOAD_PROP_CONST, identifier.line);
+                emit_string_literal(identifier.start, identifier.length, identifier.line);
+                emit_property_access(OP_LOAD_PROP_CONST, identifier.line);
                 break;
             }
             case TOKEN_OPEN_BRACKET: {
                 int line = assert(TOKEN_OPEN_BRACKET).line;
                 compile_expression();
+
+                if (peek().type == TOKEN_COLON) {
+                    assert(TOKEN_COLON);
+                    compile_expression();
+                    assert(TOKEN_CLOSE_BRACKET);
+                    emit(OP_SLICE, line);
+                    break;
+                }
+
                 assert(TOKEN_CLOSE_BRACKET);
                 emit(OP_ARRAY_GET, line);
                 break;
@@ -914,24 +1289,52 @@ static void compile_binary_operator(token_t operator_token) {
 static void compile_call_expression() {
     if (DEBUG == true) printf("Compiling compile_call_expression\n");
 
-    compile_primary_expression();
+    // calls of top level functions by name are resolved to their global slot directly
+    if (peek().type == TOKEN_IDENTIFIER) {
+        token_t identifier_token = advance();
+
+        if (peek().type == TOKEN_OPEN_PAREN && resolve_local(identifier_token) == -1) {
+            compile_direct_call_expression(identifier_token);
+            return;
+        }
+
+        emit_load_identifier(identifier_token);
+    } else {
+        compile_primary_expression();
+    }
 
     if (peek().type == TOKEN_OPEN_PAREN) {
         int line = advance().line;
-        double arg_count = compile_call_expression_args();
+        int arg_count = compile_call_expression_args();
         assert(TOKEN_CLOSE_PAREN);
 
-        emit_numeric_literal_num(arg_count, line);
         emit(OP_CALL, line);
+        emit((byte_t)arg_count, line);
     }
 }
 
-static double compile_call_expression_args() {
+static void compile_direct_call_expression(token_t identifier_token) {
+    if (DEBUG == true) printf("Compiling compile_direct_call_expression\n");
+
+    int line = assert(TOKEN_OPEN_PAREN).line;
+    int arg_count = compile_call_expression_args();
+    assert(TOKEN_CLOSE_PAREN);
+
+    emit(OP_CALL_DIRECT, line);
+    emit_uint16((uint16_t)resolve_global(identifier_token), line);
+    emit((byte_t)arg_count, line);
+}
+
+static int compile_call_expression_args() {
     if (DEBUG == true) printf("Compiling compile_call_expression_args\n");
 
-    double arg_count = 0;
+    int arg_count = 0;
 
     while (peek().type != TOKEN_CLOSE_PAREN) {
+        if (arg_count == UINT8_MAX) {
+            error_throw(ERROR_COMPILER, "Too many arguments in function call", peek().line);
+        }
+
         compile_expression();
         arg_count++;
 
@@ -997,9 +1400,7 @@ static void compile_identifier() {
     if (DEBUG == true) printf("Compiling compile_identifier\n");
 
     token_t token = assert(TOKEN_IDENTIFIER);
-
-    emit_string_literal(substring(token.start, token.length), token.line);
-    emit(OP_LOAD_VAR, token.line);
+    emit_load_identifier(token);
 }
 
 static void compile_numeric_literal() {
@@ -1020,5 +1421,5 @@ static void compile_string_literal() {
     if (DEBUG == true) printf("Compiling compile_string_literal\n");
 
     token_t token = advance();
-    emit_string_literal(substring(token.start, token.length), token.line);
+    emit_string_literal(token.start, token.length, token.line);
 }
@@ -0,0 +1,35 @@
+#include "compiler/instruction.h"
+
+int instruction_operand_size(byte_t instruction) {
+    switch (instruction) {
+        case OP_CALL:
+        case OP_STACK_CLEAR:
+            return 1;
+        case OP_LOAD_CONST:
+        case OP_LOAD_GLOBAL:
+        case OP_STORE_GLOBAL:
+        case OP_LOAD_LOCAL:
+        case OP_STORE_LOCAL:
+        case OP_ENUM_DEF:
+        case OP_NEW_OBJ:
+        case OP_ARRAY_DEF:
+        case OP_MAP_DEF:
+        case OP_LOAD_PROP:
+        case OP_LOAD_PROP_CONST:
+        case OP_LOAD_PROP_SEPARATE:
+        case OP_STORE_PROP:
+        case OP_INIT_PROP:
+            return 2;
+        case OP_CALL_DIRECT:
+            return 3;
+        case OP_JUMP:
+        case OP_JUMP_IF_FALSE:
+            return 4;
+        case OP_OBJ_DEF:
+            return 6;
+        case OP_FUNC_DEF:
+            return 9;
+        default:
+            return 0;
+    }
+}
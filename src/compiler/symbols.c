@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler/symbols.h"
+#include "utils/error.h"
+
+symbol_table_t* symbol_table_init() {
+    symbol_table_t* symbol_table = (symbol_table_t*)malloc(sizeof(symbol_table_t));
+
+    if (symbol_table == NULL) {
+        error_throw(ERROR_COMPILER, "Failed to allocate memory for symbol table", 0);
+        return NULL;
+    }
+
+    symbol_table->indices = table_init(50);
+    symbol_table->count = 0;
+    symbol_table->capacity = SYMBOL_TABLE_INITIAL_SIZE;
+    symbol_table->symbols = (symbol_t*)malloc(SYMBOL_TABLE_INITIAL_SIZE * sizeof(symbol_t));
+
+    if (symbol_table->symbols == NULL) {
+        error_throw(ERROR_COMPILER, "Failed to allocate memory for symbols", 0);
+        return NULL;
+    }
+
+    return symbol_table;
+}
+
+int symbol_table_find(symbol_table_t* symbol_table, const char* identifier) {
+    value_t* index = table_get(symbol_table->indices, identifier);
+    return index == NULL ? -1 : (int)AS_NUMBER(*index);
+}
+
+int symbol_table_resolve(symbol_table_t* symbol_table, const char* identifier, int line) {
+    int index = symbol_table_find(symbol_table, identifier);
+
+    if (index != -1) {
+        return index;
+    }
+
+    if (symbol_table->count == UINT16_MAX) {
+        error_throw(ERROR_COMPILER, "Too many top level declarations", line);
+    }
+
+    if (symbol_table->count == symbol_table->capacity) {
+        symbol_table->capacity *= 2;
+        symbol_table->symbols = (symbol_t*)realloc(symbol_table->symbols, symbol_table->capacity * sizeof(symbol_t));
+
+        if (symbol_table->symbols == NULL) {
+            error_throw(ERROR_COMPILER, "Failed to reallocate memory for symbols", line);
+        }
+    }
+
+    index = symbol_table->count++;
+
+    symbol_table->symbols[index].identifier = strdup(identifier);
+    symbol_table->symbols[index].declared = false;
+    symbol_table->symbols[index].line = line;
+
+    value_t value = NUMBER_VALUE(index);
+    table_set(symbol_table->indices, identifier, value);
+
+    return index;
+}
+
+int symbol_table_declare(symbol_table_t* symbol_table, const char* identifier, int line) {
+    int index = symbol_table_resolve(symbol_table, identifier, line);
+    symbol_table->symbols[index].declared = true;
+    return index;
+}
+
+symbol_t* symbol_table_undeclared(symbol_table_t* symbol_table) {
+    for (int i = 0; i < symbol_table->count; i++) {
+        if (!symbol_table->symbols[i].declared) {
+            return &symbol_table->symbols[i];
+        }
+    }
+
+    return NULL;
+}
+
+void symbol_table_free(symbol_table_t* symbol_table) {
+    for (int i = 0; i < symbol_table->count; i++) {
+        free(symbol_table->symbols[i].identifier);
+    }
+
+    table_free(symbol_table->indices);
+    free(symbol_table->indices);
+    free(symbol_table->symbols);
+    free(symbol_table);
+}
@@ -11,6 +11,7 @@
 #include "compiler/bytecode.h"
 #include "compiler/instruction.h"
 #include "vm/vm.h"
+#include "vm/register_vm.h"
 #include "interpreter/interpreter.h"
 #include "utils/common.h"
 #include "utils/io.h"
@@ -21,14 +22,16 @@
 const char* OP_CODE_LABELS[] = {
     "LOAD_CONST",
 
-    "DECLARE_VAR",
-    "LOAD_VAR",
-    "STORE_VAR",
+    "LOAD_GLOBAL",
+    "STORE_GLOBAL",
+    "LOAD_LOCAL",
+    "STORE_LOCAL",
 
     "FUNC_DEF",
     "FUNC_END",
     "RETURN",
     "CALL",
+    "CALL_DIRECT",
 
     "ENUM_DEF",
     "STORE_ENUM",
@@ -39,12 +42,17 @@ const char* OP_CODE_LABELS[] = {
     "NEW_OBJ",
     "LOAD_PROP",
     "LOAD_PROP_CONST",
+    "LOAD_PROP_SEPARATE",
     "STORE_PROP",
     "INIT_PROP",
 
     "ARRAY_DEF",
     "ARRAY_GET",
+    "ARRAY_GET_SEPARATE",
     "ARRAY_SET",
+    "SEPARATE",
+    "SLICE",
+    "MAP_DEF",
 
     "SIZEOF",
 
@@ -53,6 +61,8 @@ const char* OP_CODE_LABELS[] = {
 
     "ADD",
     "SUB",
+    "ADD_ASSIGN",
+    "SUB_ASSIGN",
     "MUL",
     "DIV",
     "DIV_FLOOR",
@@ -120,7 +130,7 @@ char* get_line(const char* str, int i) {
     return NULL;
 }
 
-void interpret(const char* source_code) {
+void interpret(const char* source_code, bool use_register_vm) {
     loaded_source_code = source_code;
 
     printf("\033[32mINFO:\033[0m Starting GEN v%s\n", VERSION);
@@ -135,10 +145,18 @@ void interpret(const char* source_code) {
     print_bytecode(bytecode);
     #endif
 
-    vm_init(bytecode);
+    clock_t start;
+
+    if (use_register_vm) {
+        register_vm_init(bytecode);
+        start = clock();
+        register_vm_run(false);
+    } else {
+        vm_init(bytecode);
+        start = clock();
+        vm_run(false);
+    }
 
-    clock_t start = clock();
-    vm_run(false);
     clock_t end = clock();
 
     double elapsed_time = (double)(end - start) / CLOCKS_PER_SEC;
@@ -161,7 +179,7 @@ static void print_bytecode(bytecode_t* bytecode) {
 
     int last_line = -1;
 
-    for (int i = 0; i < bytecode->count - 7; ++i) {
+    for (int i = 0; i < bytecode->count - 1 - instruction_operand_size(OP_CALL_DIRECT); ++i) {
         int op_index = i;
 
         if (bytecode->lines[i] != last_line) {
@@ -172,27 +190,15 @@ static void print_bytecode(bytecode_t* bytecode) {
 
         last_line = bytecode->lines[i];
 
-        switch (bytecode->instructions[i]) {
-            case OP_LOAD_CONST: {
-                printf("%d: (line %d) %s\n", op_index, bytecode->lines[i], OP_CODE_LABELS[bytecode->instructions[i]]);
-                i++;
-
-                byte_t bytes[2];
-                for (int j = i; j < i + 2; j++) {
-                    bytes[j - i] = bytecode->instructions[j];
-                }
+        printf("%d: (line %d) %s\n", op_index, bytecode->lines[i], OP_CODE_LABELS[bytecode->instructions[i]]);
 
-                printf("%d: (line %d) %d\n", op_index + 1, bytecode->lines[i], bytes[0]);
-                printf("%d: (line %d) %d\n", op_index + 2, bytecode->lines[i], bytes[1]);
+        int operand_size = instruction_operand_size(bytecode->instructions[i]);
 
-                i += 1;
-                break;
-            }
-            default: {
-                printf("%d: (line %d) %s\n", op_index, bytecode->lines[i], OP_CODE_LABELS[bytecode->instructions[i]]);
-                break;
-            }
+        for (int j = 1; j <= operand_size; j++) {
+            printf("%d: (line %d) %d\n", op_index + j, bytecode->lines[i], bytecode->instructions[i + j]);
         }
+
+        i += operand_size;
     }
 
     printf("------------------------------\n");
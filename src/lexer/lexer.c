@@ -218,6 +218,7 @@ token_t lexer_get_token() {
         case '[': return make_token(TOKEN_OPEN_BRACKET);
         case ']': return make_token(TOKEN_CLOSE_BRACKET);
         case '.': return make_token(TOKEN_DOT);
+        case ':': return make_token(TOKEN_COLON);
         case ',': return make_token(TOKEN_COMMA);
         case ';': return make_token(TOKEN_SEMICOLON);
         case '+': return make_token(TOKEN_PLUS);
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,15 +8,17 @@
 #include "interpreter/interpreter.h"
 
 int main(int argc, const char* argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: GEN [path]\n");
+    bool use_register_vm = argc == 3 && strcmp(argv[1], "--register") == 0;
+
+    if (argc != 2 && !use_register_vm) {
+        fprintf(stderr, "Usage: GEN [--register] [path]\n");
         exit(64);
     }
 
-    const char* file_path = argv[1];
+    const char* file_path = argv[argc - 1];
     char* source_code = read_file(file_path);
     
-    interpret(source_code);
+    interpret(source_code, use_register_vm);
 
     return 0;
 }
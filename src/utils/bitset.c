@@ -0,0 +1,48 @@
+#include <string.h>
+
+#include "utils/bitset.h"
+#include "utils/kernels.h"
+#include "utils/memory.h"
+
+bitset_t* bitset_init(int size) {
+    bitset_t* bitset = (bitset_t*)memory_allocate(HEAP_BITSET, sizeof(bitset_t));
+    bitset->size = size;
+    bitset->words = (uint64_t*)memory_reallocate(NULL, 0, BITSET_WORDS(size) * sizeof(uint64_t));
+
+    for (int i = 0; i < BITSET_WORDS(size); i++) {
+        bitset->words[i] = 0;
+    }
+
+    return bitset;
+}
+
+long bitset_count(bitset_t* bitset) {
+    return kernel_popcount(bitset->words, BITSET_WORDS(bitset->size));
+}
+
+bitset_t* bitset_union(bitset_t* left, bitset_t* right) {
+    bitset_t* larger = left->size >= right->size ? left : right;
+    bitset_t* smaller = larger == left ? right : left;
+    bitset_t* result = bitset_init(larger->size);
+    int common = BITSET_WORDS(smaller->size);
+    int rest = BITSET_WORDS(larger->size) - common;
+
+    // the words past the end of the smaller bitset are copied from the larger one, and empty bitsets have no words
+    kernel_or(result->words, left->words, right->words, common);
+
+    if (rest > 0) {
+        memcpy(result->words + common, larger->words + common, rest * sizeof(uint64_t));
+    }
+
+    return result;
+}
+
+bitset_t* bitset_intersection(bitset_t* left, bitset_t* right) {
+    bitset_t* result = bitset_init(left->size < right->size ? left->size : right->size);
+    int common = BITSET_WORDS(result->size);
+
+    // the smaller bitset has zeros beyond its size, so the last word needs no masking
+    kernel_and(result->words, left->words, right->words, common);
+
+    return result;
+}
@@ -4,28 +4,285 @@
 
 #include "utils/common.h"
 #include "utils/error.h"
+#include "utils/memory.h"
+#include "utils/shape.h"
 
 // VALUE
 
 enum_t* enum_init() {
-    enum_t* enumeration = (enum_t*)malloc(sizeof(enum_t));
+    enum_t* enumeration = (enum_t*)memory_allocate(HEAP_ENUM, sizeof(enum_t));
     enumeration->values = table_init(50);
     return enumeration;
 }
 
-array_t* array_init(int size) {
-    array_t* array = (array_t*)malloc(sizeof(array_t));
+// STRING
+
+static char** segment_stack = NULL;
+static int segment_capacity = 0;
+
+static inline rope_t* as_rope(char* string) {
+    return (rope_t*)string;
+}
+
+char* string_concat(char* left, char* right) {
+    size_t left_length = string_length(left);
+    size_t right_length = string_length(right);
+
+    if (left_length == 0) {
+        return right;
+    }
+
+    if (right_length == 0) {
+        return left;
+    }
+
+    if (left_length + right_length < ROPE_MIN_LENGTH) {
+        char* string = memory_allocate_string(left_length + right_length);
+        memcpy(string, string_chars(left), left_length);
+        memcpy(string + left_length, string_chars(right), right_length);
+        return string;
+    }
+
+    string_header_t* header = (string_header_t*)memory_allocate(HEAP_ROPE, sizeof(string_header_t) + sizeof(rope_t));
+    header->length = left_length + right_length;
+    header->hash = 0;
+    header->flags = STRING_ROPE;
+
+    rope_t* rope = (rope_t*)(header + 1);
+    rope->left = STRING_VALUE(left);
+    rope->right = STRING_VALUE(right);
+    memory_write_barrier(header, rope->left);
+    memory_write_barrier(header, rope->right);
+
+    return (char*)rope;
+}
+
+char* string_slice(char* string, size_t start, size_t length) {
+    if (length == string_length(string)) {
+        return string;
+    }
+
+    if (length == 0) {
+        return memory_intern_string("", 0);
+    }
+
+    if (length == 1) {
+        return memory_character_string(string_chars(string)[start]);
+    }
+
+    if (length < SLICE_MIN_LENGTH) {
+        return memory_copy_string(string_chars(string) + start, length);
+    }
+
+    // slices always view a flat string, so slicing a slice views the same parent
+    if (string_header(string)->flags & STRING_SLICE) {
+        start += ((slice_t*)string)->offset;
+        string = AS_STRING(((slice_t*)string)->parent);
+    } else {
+        string = string_flatten(string);
+    }
+
+    string_header_t* header = (string_header_t*)memory_allocate(HEAP_SLICE, sizeof(string_header_t) + sizeof(slice_t));
+    header->length = length;
+    header->hash = 0;
+    header->flags = STRING_SLICE;
+
+    slice_t* slice = (slice_t*)(header + 1);
+    slice->parent = STRING_VALUE(string);
+    slice->offset = start;
+    memory_write_barrier(header, slice->parent);
+
+    return (char*)slice;
+}
+
+void string_for_each_segment(char* string, void (*callback)(const char* chars, size_t length, void* context), void* context) {
+    // ropes built in loops are deeply nested, so they are walked with an explicit stack of pending right operands
+    int count = 0;
+
+    while (true) {
+        while (string_header(string)->flags & STRING_ROPE) {
+            if (count == segment_capacity) {
+                segment_capacity = segment_capacity == 0 ? 64 : segment_capacity * 2;
+                segment_stack = (char**)realloc(segment_stack, segment_capacity * sizeof(char*));
+
+                if (segment_stack == NULL) {
+                    error_throw(ERROR_RUNTIME, "Failed to allocate memory for a rope traversal", 0);
+                }
+            }
+
+            segment_stack[count++] = AS_STRING(as_rope(string)->right);
+            string = AS_STRING(as_rope(string)->left);
+        }
+
+        callback(string_chars(string), string_length(string), context);
+
+        if (count == 0) {
+            return;
+        }
+
+        string = segment_stack[--count];
+    }
+}
+
+static void copy_segment(const char* chars, size_t length, void* context) {
+    char** destination = (char**)context;
+    memcpy(*destination, chars, length);
+    *destination += length;
+}
+
+char* string_flatten(char* string) {
+    if (string_header(string)->flags & STRING_SLICE) {
+        slice_t* slice = (slice_t*)string;
+
+        // a slice ending its parent is already null terminated
+        if (slice->offset + string_length(string) == string_length(AS_STRING(slice->parent))) {
+            return AS_STRING(slice->parent) + slice->offset;
+        }
+
+        // view a null terminated copy from now on, releasing the parent
+        slice->parent = STRING_VALUE(memory_copy_string(string_chars(string), string_length(string)));
+        slice->offset = 0;
+        memory_write_barrier(string_header(string), slice->parent);
+
+        return AS_STRING(slice->parent);
+    }
+
+    if (!(string_header(string)->flags & STRING_ROPE)) {
+        return string;
+    }
+
+    rope_t* rope = as_rope(string);
+
+    // an already flattened rope holds its characters as its left operand
+    if (string_length(AS_STRING(rope->left)) == string_length(string)) {
+        return AS_STRING(rope->left);
+    }
+
+    char* flat = memory_allocate_string(string_length(string));
+    char* destination = flat;
+    string_for_each_segment(string, copy_segment, &destination);
+
+    // release the operands, which are no longer needed once the characters are stored in the rope
+    rope->left = STRING_VALUE(flat);
+    rope->right = STRING_VALUE(memory_intern_string("", 0));
+    memory_write_barrier(string_header(string), rope->left);
+
+    return flat;
+}
+
+array_t* array_init(int size, array_kind kind) {
+    array_t* array = (array_t*)memory_allocate(HEAP_ARRAY, sizeof(array_t));
     array->size = size;
-    array->elements = (value_t*)malloc(size * sizeof(value_t));
+    array->capacity = size;
+    array->refcount = 0;
+    array->kind = kind;
+    array->elements.values = (value_t*)memory_reallocate(NULL, 0, size * array_element_size(kind));
     return array;
 }
 
+array_t* array_copy(array_t* array) {
+    array_t* copy = array_init(array->size, array->kind);
+
+    if (array->kind != ARRAY_VALUES) {
+        memcpy(copy->elements.values, array->elements.values, array->size * array_element_size(array->kind));
+        return copy;
+    }
+
+    for (int i = 0; i < array->size; i++) {
+        copy->elements.values[i] = array->elements.values[i];
+        value_retain(array->elements.values[i]);
+        memory_write_barrier(copy, array->elements.values[i]);
+    }
+
+    return copy;
+}
+
+array_kind array_kind_of(value_t element) {
+    if (IS_NUMBER(element)) {
+        return ARRAY_NUMBERS;
+    }
+
+    if (IS_BOOLEAN(element)) {
+        return ARRAY_BOOLEANS;
+    }
+
+    return ARRAY_VALUES;
+}
+
+size_t array_element_size(array_kind kind) {
+    switch (kind) {
+        case ARRAY_NUMBERS: return sizeof(number_t);
+        case ARRAY_BOOLEANS: return sizeof(boolean_t);
+        default: return sizeof(value_t);
+    }
+}
+
+// converts the packed elements of an array to values
+static void array_box(array_t* array) {
+    value_t* values = (value_t*)memory_reallocate(NULL, 0, array->capacity * sizeof(value_t));
+
+    for (int i = 0; i < array->size; i++) {
+        values[i] = array_get_element(array, i);
+    }
+
+    memory_reallocate(array->elements.values, array->capacity * array_element_size(array->kind), 0);
+    array->elements.values = values;
+    array->kind = ARRAY_VALUES;
+}
+
+// makes the kind of an array fit an element about to be stored in it
+static inline void array_fit(array_t* array, value_t element) {
+    array_kind kind = array_kind_of(element);
+
+    if (kind == array->kind || array->kind == ARRAY_VALUES) {
+        return;
+    }
+
+    if (array->size > 0) {
+        array_box(array);
+        return;
+    }
+
+    size_t capacity = array->capacity;
+    array->elements.values = (value_t*)memory_reallocate(array->elements.values, capacity * array_element_size(array->kind), capacity * array_element_size(kind));
+    array->kind = kind;
+}
+
+static inline void array_store(array_t* array, int index, value_t element) {
+    switch (array->kind) {
+        case ARRAY_NUMBERS: array->elements.numbers[index] = AS_NUMBER(element); break;
+        case ARRAY_BOOLEANS: array->elements.booleans[index] = AS_BOOLEAN(element); break;
+        default: array->elements.values[index] = element; break;
+    }
+}
+
 void array_add_element(array_t* array, int index, value_t element) {
     if (index >= array->size) {
         error_throw(ERROR_RUNTIME, "Index out of range in array_add_element", 0);
     }
 
-    array->elements[index] = element;
+    array_fit(array, element);
+    array_store(array, index, element);
+
+    if (array->kind == ARRAY_VALUES) {
+        memory_write_barrier(array, element);
+    }
+}
+
+void array_set_element(array_t* array, int index, value_t element) {
+    if (index >= array->size) {
+        error_throw(ERROR_RUNTIME, "Index out of range in array_set_element", 0);
+    }
+
+    array_fit(array, element);
+
+    if (array->kind != ARRAY_VALUES) {
+        array_store(array, index, element);
+        return;
+    }
+
+    value_store(&array->elements.values[index], element);
+    memory_write_barrier(array, element);
 }
 
 value_t array_get_element(array_t* array, int index) {
@@ -33,153 +290,469 @@ value_t array_get_element(array_t* array, int index) {
         error_throw(ERROR_RUNTIME, "Index out of range in array_get_element", 0);
     }
 
-    return array->elements[index];
+    switch (array->kind) {
+        case ARRAY_NUMBERS: return NUMBER_VALUE(array->elements.numbers[index]);
+        case ARRAY_BOOLEANS: return BOOLEAN_VALUE(array->elements.booleans[index]);
+        default: return array->elements.values[index];
+    }
+}
+
+static void array_resize(array_t* array, int capacity) {
+    size_t element_size = array_element_size(array->kind);
+    array->elements.values = (value_t*)memory_reallocate(array->elements.values, array->capacity * element_size, capacity * element_size);
+    array->capacity = capacity;
 }
 
 void array_append(array_t* array, value_t element) {
-    array->size++;
-    array->elements = (value_t*)realloc(array->elements, array->size * sizeof(value_t));
-    array->elements[array->size - 1] = element;
+    array_fit(array, element);
+
+    if (array->size == array->capacity) {
+        array_resize(array, array->capacity < ARRAY_MIN_CAPACITY ? ARRAY_MIN_CAPACITY : array->capacity * 2);
+    }
+
+    array_store(array, array->size++, element);
+
+    if (array->kind == ARRAY_VALUES) {
+        value_retain(element);
+        memory_write_barrier(array, element);
+    }
+}
+
+// converts an array holding numbers only to ARRAY_NUMBERS, returns whether the array now is one
+bool array_pack_numbers(array_t* array) {
+    if (array->kind == ARRAY_NUMBERS) {
+        return true;
+    }
+
+    for (int i = 0; i < array->size; i++) {
+        if (!IS_NUMBER(array_get_element(array, i))) {
+            return false;
+        }
+    }
+
+    number_t* numbers = (number_t*)memory_reallocate(NULL, 0, array->capacity * sizeof(number_t));
+
+    for (int i = 0; i < array->size; i++) {
+        numbers[i] = AS_NUMBER(array_get_element(array, i));
+    }
+
+    memory_reallocate(array->elements.values, array->capacity * array_element_size(array->kind), 0);
+    array->elements.numbers = numbers;
+    array->kind = ARRAY_NUMBERS;
+
+    return true;
 }
 
 void array_remove(array_t* array, int count) {
-    if (count >= array->size) {
-        array->size = 0;
-        free(array->elements);
-        array->elements = NULL;
-    } else {
-        array->size -= count;
-        array->elements = (value_t*)realloc(array->elements, array->size * sizeof(value_t));
+    int size = count >= array->size ? 0 : array->size - count;
+
+    if (array->kind == ARRAY_VALUES) {
+        for (int i = size; i < array->size; i++) {
+            value_release(array->elements.values[i]);
+        }
+    }
+
+    array->size = size;
+
+    // shrinking only below a quarter keeps alternating appends and removals from resizing every time
+    if (array->size < array->capacity / 4 && array->capacity > ARRAY_MIN_CAPACITY) {
+        int capacity = array->capacity / 2;
+
+        while (array->size < capacity / 4 && capacity > ARRAY_MIN_CAPACITY) {
+            capacity /= 2;
+        }
+
+        array_resize(array, capacity < ARRAY_MIN_CAPACITY ? ARRAY_MIN_CAPACITY : capacity);
     }
 }
 
 object_t* object_init() {
-    object_t* object = (object_t*)malloc(sizeof(object_t));
-    object->properties = table_init(50);
+    object_t* object = (object_t*)memory_allocate(HEAP_OBJECT, sizeof(object_t));
+    object->shape = shape_root();
+    object->capacity = 0;
+    object->slots = NULL;
     return object;
 }
 
+object_t* object_clone(shape_t* shape, const value_t* slots) {
+    object_t* object = (object_t*)memory_allocate(HEAP_OBJECT, sizeof(object_t));
+    object->shape = shape;
+    object->capacity = shape->count;
+    object->slots = (value_t*)memory_reallocate(NULL, 0, shape->count * sizeof(value_t));
+
+    // templates without properties have no slots to copy
+    if (shape->count > 0) {
+        memcpy(object->slots, slots, shape->count * sizeof(value_t));
+    }
+
+    for (int i = 0; i < shape->count; i++) {
+        memory_write_barrier(object, slots[i]);
+    }
+
+    return object;
+}
+
+value_t* object_get_property(object_t* object, const char* identifier) {
+    int slot = shape_lookup(object->shape, memory_intern_string(identifier, strlen(identifier)));
+    return slot == -1 ? NULL : &object->slots[slot];
+}
+
 void object_add_property(object_t* object, char* identifier, value_t element) {
-    table_set(object->properties, identifier, element);
+    identifier = memory_intern_string(identifier, strlen(identifier));
+    int slot = shape_lookup(object->shape, identifier);
+
+    if (slot == -1) {
+        object_transition(object, shape_transition(object->shape, identifier));
+        slot = object->shape->count - 1;
+    }
+
+    object->slots[slot] = element;
+    memory_write_barrier(object, element);
 }
 
-// TABLE
+void object_transition(object_t* object, shape_t* shape) {
+    if (shape->count > object->capacity) {
+        int capacity = object->capacity < 4 ? 4 : object->capacity * 2;
 
-static unsigned long hash_function(const char* str) {
-    unsigned long hash = 5381;
-    int c;
+        while (capacity < shape->count) {
+            capacity *= 2;
+        }
 
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c;
+        object->slots = (value_t*)memory_reallocate(object->slots, object->capacity * sizeof(value_t), capacity * sizeof(value_t));
+        object->capacity = capacity;
     }
 
-    return hash;
+    object->shape = shape;
 }
 
-table_t* table_init(int capacity) {
-    table_t* table = (table_t*)malloc(sizeof(table_t));
-    table->capacity = capacity;
-    table->size = 0;
-    table->buckets = (entry_t**)calloc(capacity, sizeof(entry_t*));
+// MAP
+
+static unsigned long hash_key(value_t key) {
+    if (IS_STRING(key)) {
+        return string_hash(AS_STRING(key));
+    }
+
+    if (IS_BOOLEAN(key)) {
+        return AS_BOOLEAN(key) ? 1231 : 1237;
+    }
+
+    // adding 0 turns -0 into 0, so that equal numbers hash alike
+    number_t number = AS_NUMBER(key) + 0.0;
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+
+    return (unsigned long)bits;
+}
+
+static bool keys_equal(value_t left, value_t right) {
+    if (IS_STRING(left) && IS_STRING(right)) {
+        char* left_string = AS_STRING(left);
+        char* right_string = AS_STRING(right);
+
+        if (left_string == right_string) {
+            return true;
+        }
+
+        if (memory_is_interned(left_string) && memory_is_interned(right_string)) {
+            return false;
+        }
+
+        size_t length = string_length(left_string);
+        return length == string_length(right_string) && memcmp(string_chars(left_string), string_chars(right_string), length) == 0;
+    }
+
+    if (IS_NUMBER(left) && IS_NUMBER(right)) {
+        return AS_NUMBER(left) == AS_NUMBER(right);
+    }
+
+    return IS_BOOLEAN(left) && IS_BOOLEAN(right) && AS_BOOLEAN(left) == AS_BOOLEAN(right);
+}
+
+static inline int bucket_count(map_t* map) {
+    return map->capacity * 2;
+}
+
+static void allocate_buckets(map_t* map) {
+    map->buckets = (int*)memory_reallocate(NULL, 0, bucket_count(map) * sizeof(int));
+
+    for (int i = 0; i < bucket_count(map); i++) {
+        map->buckets[i] = -1;
+    }
+}
+
+// returns the bucket holding the index of the entry of the key, or the empty bucket where it belongs
+static int* find_bucket(map_t* map, value_t key, unsigned long hash) {
+    size_t mask = bucket_count(map) - 1;
+    size_t index = hash & mask;
+
+    while (true) {
+        int* bucket = &map->buckets[index];
+
+        if (*bucket == -1) {
+            return bucket;
+        }
+
+        map_entry_t* entry = &map->entries[*bucket];
+
+        if (entry->hash == hash && keys_equal(entry->key, key)) {
+            return bucket;
+        }
+
+        index = (index + 1) & mask;
+    }
+}
+
+// returns the bucket holding the index of an entry, which must be in the map
+static int* find_entry_bucket(map_t* map, int entry) {
+    size_t mask = bucket_count(map) - 1;
+    size_t index = map->entries[entry].hash & mask;
+
+    while (map->buckets[index] != entry) {
+        index = (index + 1) & mask;
+    }
+
+    return &map->buckets[index];
+}
+
+map_t* map_init(int capacity) {
+    map_t* map = (map_t*)memory_allocate(HEAP_MAP, sizeof(map_t));
+    map->count = 0;
+    map->capacity = MAP_MIN_CAPACITY;
+    map->refcount = 0;
+
+    while (map->capacity < capacity) {
+        map->capacity *= 2;
+    }
+
+    map->entries = (map_entry_t*)memory_reallocate(NULL, 0, map->capacity * sizeof(map_entry_t));
+    allocate_buckets(map);
+
+    return map;
+}
+
+map_t* map_copy(map_t* map) {
+    map_t* copy = map_init(map->capacity);
+    copy->count = map->count;
+
+    memcpy(copy->entries, map->entries, map->count * sizeof(map_entry_t));
+    memcpy(copy->buckets, map->buckets, bucket_count(map) * sizeof(int));
+
+    for (int i = 0; i < map->count; i++) {
+        value_retain(map->entries[i].value);
+        memory_write_barrier(copy, map->entries[i].key);
+        memory_write_barrier(copy, map->entries[i].value);
+    }
+
+    return copy;
+}
+
+static void map_grow(map_t* map) {
+    int capacity = map->capacity * 2;
+
+    map->entries = (map_entry_t*)memory_reallocate(map->entries, map->capacity * sizeof(map_entry_t), capacity * sizeof(map_entry_t));
+    memory_reallocate(map->buckets, bucket_count(map) * sizeof(int), 0);
+
+    map->capacity = capacity;
+    allocate_buckets(map);
+
+    for (int i = 0; i < map->count; i++) {
+        *find_bucket(map, map->entries[i].key, map->entries[i].hash) = i;
+    }
+}
+
+value_t* map_get(map_t* map, value_t key) {
+    int index = *find_bucket(map, key, hash_key(key));
+    return index == -1 ? NULL : &map->entries[index].value;
+}
+
+void map_set(map_t* map, value_t key, value_t value) {
+    unsigned long hash = hash_key(key);
+    int* bucket = find_bucket(map, key, hash);
+
+    if (*bucket != -1) {
+        value_store(&map->entries[*bucket].value, value);
+        memory_write_barrier(map, value);
+        return;
+    }
 
-    if (table->buckets == NULL) {
-        fprintf(stderr, "Failed to allocate memory for hash table buckets.\n");
+    if (map->count == map->capacity) {
+        map_grow(map);
+        bucket = find_bucket(map, key, hash);
+    }
+
+    *bucket = map->count;
+    map->entries[map->count++] = (map_entry_t){ .key = key, .value = value, .hash = hash };
+
+    value_retain(value);
+    memory_write_barrier(map, key);
+    memory_write_barrier(map, value);
+}
+
+bool map_delete(map_t* map, value_t key) {
+    int* bucket = find_bucket(map, key, hash_key(key));
+    int entry = *bucket;
+
+    if (entry == -1) {
+        return false;
+    }
+
+    value_release(map->entries[entry].value);
+
+    size_t mask = bucket_count(map) - 1;
+    size_t hole = bucket - map->buckets;
+    size_t index = (hole + 1) & mask;
+
+    // shift back every following bucket of the cluster whose home bucket is not between the hole and itself
+    while (map->buckets[index] != -1) {
+        size_t home = map->entries[map->buckets[index]].hash & mask;
+
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            map->buckets[hole] = map->buckets[index];
+            hole = index;
+        }
+
+        index = (index + 1) & mask;
+    }
+
+    map->buckets[hole] = -1;
+
+    // the last entry fills the place of the deleted one, so the entries stay dense
+    int last = --map->count;
+
+    if (entry != last) {
+        *find_entry_bucket(map, last) = entry;
+        map->entries[entry] = map->entries[last];
+    }
+
+    return true;
+}
+
+// TABLE
+
+static entry_t* allocate_entries(int capacity) {
+    entry_t* entries = (entry_t*)calloc(capacity, sizeof(entry_t));
+
+    if (entries == NULL) {
+        fprintf(stderr, "Failed to allocate memory for hash table entries.\n");
         exit(EXIT_FAILURE);
     }
 
-    return table;
+    return entries;
 }
 
-void entry_free(entry_t* entry) {
-    if (entry == NULL) return;
-    free(entry->key);
-    if (entry->value.type == TYPE_STRING) {
-        free(entry->value.as.string);
+table_t* table_init(int capacity) {
+    table_t* table = (table_t*)malloc(sizeof(table_t));
+
+    // capacities are powers of two, so that the bucket of a hash is a mask away
+    int power = 8;
+
+    while (power < capacity) {
+        power *= 2;
     }
-    entry_free(entry->next);
-    free(entry);
+
+    table->capacity = power;
+    table->size = 0;
+    table->entries = allocate_entries(power);
+
+    return table;
 }
 
 void table_free(table_t* table) {
-    for (int i = 0; i < table->capacity; i++) {
-        entry_free(table->buckets[i]);
-    }
-    free(table->buckets);
-    table->buckets = NULL;
+    free(table->entries);
+    table->entries = NULL;
     table->size = 0;
     table->capacity = 0;
 }
 
-void table_set(table_t* table, const char* key, value_t value) {
-    unsigned long hash = hash_function(key);
-    size_t index = hash % table->capacity;
+// returns the entry holding the key, or the empty entry where it belongs
+static entry_t* find_entry(entry_t* entries, int capacity, const char* key, unsigned long hash) {
+    size_t index = hash & (capacity - 1);
 
-    entry_t* current = table->buckets[index];
+    while (true) {
+        entry_t* entry = &entries[index];
 
-    while (current != NULL) {
-        if (strcmp(current->key, key) == 0) {
-            current->value = value;
-            return;
+        // keys are interned, so an interned string only ever matches by pointer
+        if (entry->key == NULL || entry->key == key) {
+            return entry;
         }
 
-        current = current->next;
+        if (entry->hash == hash && !memory_is_interned(key) && string_length(entry->key) == string_length(key) && memcmp(entry->key, key, string_length(key)) == 0) {
+            return entry;
+        }
+
+        index = (index + 1) & (capacity - 1);
     }
+}
 
-    entry_t* new_entry = (entry_t*)malloc(sizeof(entry_t));
-    if (new_entry == NULL) {
-        fprintf(stderr, "Failed to allocate memory for new hash table entry.\n");
-        exit(EXIT_FAILURE);
+static void table_grow(table_t* table) {
+    int capacity = table->capacity * 2;
+    entry_t* entries = allocate_entries(capacity);
+
+    for (int i = 0; i < table->capacity; i++) {
+        entry_t* entry = &table->entries[i];
+
+        if (entry->key != NULL) {
+            *find_entry(entries, capacity, entry->key, entry->hash) = *entry;
+        }
     }
 
-    new_entry->key = (char*)malloc(strlen(key) * sizeof(char));
-    new_entry->key = strdup(key);
-    new_entry->value = value;
-    new_entry->next = table->buckets[index];
-    table->buckets[index] = new_entry;
-    table->size++;
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
 }
 
-value_t* table_get(table_t* table, const char* key) {
-    unsigned long hash = hash_function(key);
-    size_t index = hash % table->capacity;
-    entry_t* current = table->buckets[index];
+void table_set(table_t* table, const char* key, value_t value) {
+    if ((table->size + 1) * TABLE_MAX_LOAD_DENOMINATOR > table->capacity * TABLE_MAX_LOAD_NUMERATOR) {
+        table_grow(table);
+    }
 
-    while (current != NULL) {
-        if (strcmp(current->key, key) == 0) {
-            return &current->value;
-        }
+    unsigned long hash = string_hash(key);
+    entry_t* entry = find_entry(table->entries, table->capacity, key, hash);
 
-        current = current->next;
+    if (entry->key == NULL) {
+        entry->key = memory_is_interned(key) ? (char*)key : memory_intern_string(key, string_length(key));
+        entry->hash = hash;
+        table->size++;
     }
 
-    return NULL;
+    entry->value = value;
+}
+
+value_t* table_get(table_t* table, const char* key) {
+    entry_t* entry = find_entry(table->entries, table->capacity, key, string_hash(key));
+    return entry->key == NULL ? NULL : &entry->value;
 }
 
 void table_delete(table_t* table, const char* key) {
-    unsigned long hash = hash_function(key);
-    size_t index = hash % table->capacity;
-
-    entry_t* current = table->buckets[index];
-    entry_t* prev = NULL;
-
-    while (current != NULL) {
-        if (strcmp(current->key, key) == 0) {
-            if (prev == NULL) {
-                table->buckets[index] = current->next;
-            } else {
-                prev->next = current->next;
-            }
+    entry_t* entry = find_entry(table->entries, table->capacity, key, string_hash(key));
 
-            free(current->key);
-            free(current);
-            table->size--;
+    if (entry->key == NULL) {
+        return;
+    }
 
-            return;
+    table->size--;
+
+    size_t mask = table->capacity - 1;
+    size_t hole = entry - table->entries;
+    size_t index = (hole + 1) & mask;
+
+    // shift back every following entry of the cluster whose home bucket is not between the hole and itself
+    while (table->entries[index].key != NULL) {
+        size_t home = table->entries[index].hash & mask;
+
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            table->entries[hole] = table->entries[index];
+            hole = index;
         }
 
-        prev = current;
-        current = current->next;
+        index = (index + 1) & mask;
     }
+
+    table->entries[hole].key = NULL;
 }
 
 // CONVERSIONS
@@ -201,6 +774,23 @@ uint16_t bytes_to_uint16(byte_t* bytes) {
     return value;
 }
 
+byte_t* uint32_to_bytes(uint32_t value) {
+    byte_t* bytes = (byte_t*)malloc(4 * sizeof(byte_t));
+
+    if (bytes == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate bytes for a uint32", 0);
+    }
+
+    memcpy(bytes, &value, sizeof(uint32_t));
+    return bytes;
+}
+
+uint32_t bytes_to_uint32(byte_t* bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(uint32_t));
+    return value;
+}
+
 byte_t* string_to_bytes(const char* str, size_t* size) {
     size_t str_len = strlen(str);
 
@@ -247,12 +837,13 @@ char* substring(const char* str, int length) {
         length = str_len;
     }
 
-    char* substr = (char*)malloc(length * sizeof(char));
+    char* substr = (char*)malloc((length + 1) * sizeof(char));
     if (substr == NULL) {
         return NULL;
     }
 
     strncpy(substr, str, length);
+    substr[length] = '\0';
 
     return substr;
 }
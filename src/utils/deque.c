@@ -0,0 +1,79 @@
+#include <string.h>
+
+#include "utils/deque.h"
+#include "utils/memory.h"
+
+deque_t* deque_init() {
+    deque_t* deque = (deque_t*)memory_allocate(HEAP_DEQUE, sizeof(deque_t));
+    deque->head = 0;
+    deque->count = 0;
+    deque->capacity = DEQUE_MIN_CAPACITY;
+    deque->values = (value_t*)memory_reallocate(NULL, 0, DEQUE_MIN_CAPACITY * sizeof(value_t));
+    return deque;
+}
+
+// moves the values to the start of a new buffer, unwrapping them
+static void deque_resize(deque_t* deque, int capacity) {
+    value_t* values = (value_t*)memory_reallocate(NULL, 0, capacity * sizeof(value_t));
+    int first = deque->capacity - deque->head < deque->count ? deque->capacity - deque->head : deque->count;
+
+    memcpy(values, deque->values + deque->head, first * sizeof(value_t));
+    memcpy(values + first, deque->values, (deque->count - first) * sizeof(value_t));
+    memory_reallocate(deque->values, deque->capacity * sizeof(value_t), 0);
+
+    deque->values = values;
+    deque->capacity = capacity;
+    deque->head = 0;
+}
+
+static inline void deque_reserve(deque_t* deque) {
+    if (deque->count == deque->capacity) {
+        deque_resize(deque, deque->capacity * 2);
+    }
+}
+
+// shrinking only below a quarter keeps alternating pushes and pops from resizing every time
+static inline void deque_trim(deque_t* deque) {
+    if (deque->count < deque->capacity / 4 && deque->capacity > DEQUE_MIN_CAPACITY) {
+        deque_resize(deque, deque->capacity / 2);
+    }
+}
+
+void deque_push_back(deque_t* deque, value_t value) {
+    deque_reserve(deque);
+
+    *deque_at(deque, deque->count++) = value;
+
+    value_retain(value);
+    memory_write_barrier(deque, value);
+}
+
+void deque_push_front(deque_t* deque, value_t value) {
+    deque_reserve(deque);
+
+    deque->head = (deque->head - 1) & (deque->capacity - 1);
+    deque->values[deque->head] = value;
+    deque->count++;
+
+    value_retain(value);
+    memory_write_barrier(deque, value);
+}
+
+value_t deque_pop_back(deque_t* deque) {
+    value_t value = *deque_at(deque, --deque->count);
+    value_release(value);
+
+    deque_trim(deque);
+    return value;
+}
+
+value_t deque_pop_front(deque_t* deque) {
+    value_t value = deque->values[deque->head];
+    value_release(value);
+
+    deque->head = (deque->head + 1) & (deque->capacity - 1);
+    deque->count--;
+
+    deque_trim(deque);
+    return value;
+}
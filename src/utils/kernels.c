@@ -0,0 +1,448 @@
+#include "utils/kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86
+#include <immintrin.h>
+#endif
+
+typedef struct {
+    number_t (*sum)(const number_t* values, int count);
+    number_t (*min)(const number_t* values, int count);
+    number_t (*max)(const number_t* values, int count);
+    number_t (*dot)(const number_t* left, const number_t* right, int count);
+    void (*scale)(number_t* destination, const number_t* source, number_t factor, int count);
+    void (*fill)(number_t* destination, number_t value, int count);
+    void (*or_words)(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count);
+    void (*and_words)(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count);
+    long (*popcount)(const uint64_t* words, int count);
+} kernels_t;
+
+// SCALAR
+
+static number_t scalar_sum(const number_t* values, int count) {
+    number_t sum = 0;
+
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+
+    return sum;
+}
+
+static number_t scalar_min(const number_t* values, int count) {
+    number_t min = values[0];
+
+    for (int i = 1; i < count; i++) {
+        min = values[i] < min ? values[i] : min;
+    }
+
+    return min;
+}
+
+static number_t scalar_max(const number_t* values, int count) {
+    number_t max = values[0];
+
+    for (int i = 1; i < count; i++) {
+        max = values[i] > max ? values[i] : max;
+    }
+
+    return max;
+}
+
+static number_t scalar_dot(const number_t* left, const number_t* right, int count) {
+    number_t dot = 0;
+
+    for (int i = 0; i < count; i++) {
+        dot += left[i] * right[i];
+    }
+
+    return dot;
+}
+
+static void scalar_scale(number_t* destination, const number_t* source, number_t factor, int count) {
+    for (int i = 0; i < count; i++) {
+        destination[i] = source[i] * factor;
+    }
+}
+
+static void scalar_fill(number_t* destination, number_t value, int count) {
+    for (int i = 0; i < count; i++) {
+        destination[i] = value;
+    }
+}
+
+static void scalar_or(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    for (int i = 0; i < count; i++) {
+        destination[i] = left[i] | right[i];
+    }
+}
+
+static void scalar_and(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    for (int i = 0; i < count; i++) {
+        destination[i] = left[i] & right[i];
+    }
+}
+
+static long scalar_popcount(const uint64_t* words, int count) {
+    long total = 0;
+
+    for (int i = 0; i < count; i++) {
+        total += __builtin_popcountll(words[i]);
+    }
+
+    return total;
+}
+
+static const kernels_t scalar_kernels = {
+    scalar_sum, scalar_min, scalar_max, scalar_dot, scalar_scale, scalar_fill,
+    scalar_or, scalar_and, scalar_popcount
+};
+
+#ifdef KERNELS_X86
+
+// SSE2
+//
+// Reductions keep two accumulators, so that consecutive additions do not wait for each other.
+
+__attribute__((target("sse2")))
+static number_t sse2_sum(const number_t* values, int count) {
+    __m128d first = _mm_setzero_pd();
+    __m128d second = _mm_setzero_pd();
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        first = _mm_add_pd(first, _mm_loadu_pd(values + i));
+        second = _mm_add_pd(second, _mm_loadu_pd(values + i + 2));
+    }
+
+    number_t lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(first, second));
+
+    return lanes[0] + lanes[1] + scalar_sum(values + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static number_t sse2_min(const number_t* values, int count) {
+    __m128d min = _mm_set1_pd(values[0]);
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        min = _mm_min_pd(min, _mm_loadu_pd(values + i));
+    }
+
+    number_t lanes[2];
+    _mm_storeu_pd(lanes, min);
+
+    number_t result = scalar_min(lanes, 2);
+
+    for (; i < count; i++) {
+        result = values[i] < result ? values[i] : result;
+    }
+
+    return result;
+}
+
+__attribute__((target("sse2")))
+static number_t sse2_max(const number_t* values, int count) {
+    __m128d max = _mm_set1_pd(values[0]);
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        max = _mm_max_pd(max, _mm_loadu_pd(values + i));
+    }
+
+    number_t lanes[2];
+    _mm_storeu_pd(lanes, max);
+
+    number_t result = scalar_max(lanes, 2);
+
+    for (; i < count; i++) {
+        result = values[i] > result ? values[i] : result;
+    }
+
+    return result;
+}
+
+__attribute__((target("sse2")))
+static number_t sse2_dot(const number_t* left, const number_t* right, int count) {
+    __m128d first = _mm_setzero_pd();
+    __m128d second = _mm_setzero_pd();
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        first = _mm_add_pd(first, _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+        second = _mm_add_pd(second, _mm_mul_pd(_mm_loadu_pd(left + i + 2), _mm_loadu_pd(right + i + 2)));
+    }
+
+    number_t lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(first, second));
+
+    return lanes[0] + lanes[1] + scalar_dot(left + i, right + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void sse2_scale(number_t* destination, const number_t* source, number_t factor, int count) {
+    __m128d factors = _mm_set1_pd(factor);
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(destination + i, _mm_mul_pd(_mm_loadu_pd(source + i), factors));
+    }
+
+    scalar_scale(destination + i, source + i, factor, count - i);
+}
+
+__attribute__((target("sse2")))
+static void sse2_fill(number_t* destination, number_t value, int count) {
+    __m128d values = _mm_set1_pd(value);
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(destination + i, values);
+    }
+
+    scalar_fill(destination + i, value, count - i);
+}
+
+__attribute__((target("sse2")))
+static void sse2_or(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i words = _mm_or_si128(_mm_loadu_si128((const __m128i*)(left + i)), _mm_loadu_si128((const __m128i*)(right + i)));
+        _mm_storeu_si128((__m128i*)(destination + i), words);
+    }
+
+    scalar_or(destination + i, left + i, right + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void sse2_and(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i words = _mm_and_si128(_mm_loadu_si128((const __m128i*)(left + i)), _mm_loadu_si128((const __m128i*)(right + i)));
+        _mm_storeu_si128((__m128i*)(destination + i), words);
+    }
+
+    scalar_and(destination + i, left + i, right + i, count - i);
+}
+
+// SSE2 has no population count, and CPUs without AVX2 may lack the POPCNT instruction
+static const kernels_t sse2_kernels = {
+    sse2_sum, sse2_min, sse2_max, sse2_dot, sse2_scale, sse2_fill,
+    sse2_or, sse2_and, scalar_popcount
+};
+
+// AVX2
+
+__attribute__((target("avx2")))
+static number_t avx2_sum(const number_t* values, int count) {
+    __m256d first = _mm256_setzero_pd();
+    __m256d second = _mm256_setzero_pd();
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        first = _mm256_add_pd(first, _mm256_loadu_pd(values + i));
+        second = _mm256_add_pd(second, _mm256_loadu_pd(values + i + 4));
+    }
+
+    number_t lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(first, second));
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_sum(values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static number_t avx2_min(const number_t* values, int count) {
+    __m256d min = _mm256_set1_pd(values[0]);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        min = _mm256_min_pd(min, _mm256_loadu_pd(values + i));
+    }
+
+    number_t lanes[4];
+    _mm256_storeu_pd(lanes, min);
+
+    number_t result = scalar_min(lanes, 4);
+
+    for (; i < count; i++) {
+        result = values[i] < result ? values[i] : result;
+    }
+
+    return result;
+}
+
+__attribute__((target("avx2")))
+static number_t avx2_max(const number_t* values, int count) {
+    __m256d max = _mm256_set1_pd(values[0]);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        max = _mm256_max_pd(max, _mm256_loadu_pd(values + i));
+    }
+
+    number_t lanes[4];
+    _mm256_storeu_pd(lanes, max);
+
+    number_t result = scalar_max(lanes, 4);
+
+    for (; i < count; i++) {
+        result = values[i] > result ? values[i] : result;
+    }
+
+    return result;
+}
+
+__attribute__((target("avx2")))
+static number_t avx2_dot(const number_t* left, const number_t* right, int count) {
+    __m256d first = _mm256_setzero_pd();
+    __m256d second = _mm256_setzero_pd();
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        first = _mm256_add_pd(first, _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+        second = _mm256_add_pd(second, _mm256_mul_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4)));
+    }
+
+    number_t lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(first, second));
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_dot(left + i, right + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void avx2_scale(number_t* destination, const number_t* source, number_t factor, int count) {
+    __m256d factors = _mm256_set1_pd(factor);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(destination + i, _mm256_mul_pd(_mm256_loadu_pd(source + i), factors));
+    }
+
+    scalar_scale(destination + i, source + i, factor, count - i);
+}
+
+__attribute__((target("avx2")))
+static void avx2_fill(number_t* destination, number_t value, int count) {
+    __m256d values = _mm256_set1_pd(value);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(destination + i, values);
+    }
+
+    scalar_fill(destination + i, value, count - i);
+}
+
+__attribute__((target("avx2")))
+static void avx2_or(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(left + i)), _mm256_loadu_si256((const __m256i*)(right + i)));
+        _mm256_storeu_si256((__m256i*)(destination + i), words);
+    }
+
+    scalar_or(destination + i, left + i, right + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void avx2_and(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(left + i)), _mm256_loadu_si256((const __m256i*)(right + i)));
+        _mm256_storeu_si256((__m256i*)(destination + i), words);
+    }
+
+    scalar_and(destination + i, left + i, right + i, count - i);
+}
+
+// every CPU with AVX2 has the POPCNT instruction, four counters keep its pipelines busy
+__attribute__((target("popcnt")))
+static long avx2_popcount(const uint64_t* words, int count) {
+    long totals[4] = {0, 0, 0, 0};
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        totals[0] += __builtin_popcountll(words[i]);
+        totals[1] += __builtin_popcountll(words[i + 1]);
+        totals[2] += __builtin_popcountll(words[i + 2]);
+        totals[3] += __builtin_popcountll(words[i + 3]);
+    }
+
+    for (; i < count; i++) {
+        totals[0] += __builtin_popcountll(words[i]);
+    }
+
+    return totals[0] + totals[1] + totals[2] + totals[3];
+}
+
+static const kernels_t avx2_kernels = {
+    avx2_sum, avx2_min, avx2_max, avx2_dot, avx2_scale, avx2_fill,
+    avx2_or, avx2_and, avx2_popcount
+};
+
+#endif
+
+// DISPATCH
+
+static const kernels_t* kernels = NULL;
+
+static inline const kernels_t* select_kernels() {
+    if (kernels != NULL) {
+        return kernels;
+    }
+
+    kernels = &scalar_kernels;
+
+    #ifdef KERNELS_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        kernels = &avx2_kernels;
+    } else if (__builtin_cpu_supports("sse2")) {
+        kernels = &sse2_kernels;
+    }
+    #endif
+
+    return kernels;
+}
+
+number_t kernel_sum(const number_t* values, int count) {
+    return select_kernels()->sum(values, count);
+}
+
+number_t kernel_min(const number_t* values, int count) {
+    return select_kernels()->min(values, count);
+}
+
+number_t kernel_max(const number_t* values, int count) {
+    return select_kernels()->max(values, count);
+}
+
+number_t kernel_dot(const number_t* left, const number_t* right, int count) {
+    return select_kernels()->dot(left, right, count);
+}
+
+void kernel_scale(number_t* destination, const number_t* source, number_t factor, int count) {
+    select_kernels()->scale(destination, source, factor, count);
+}
+
+void kernel_fill(number_t* destination, number_t value, int count) {
+    select_kernels()->fill(destination, value, count);
+}
+
+void kernel_or(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    select_kernels()->or_words(destination, left, right, count);
+}
+
+void kernel_and(uint64_t* destination, const uint64_t* left, const uint64_t* right, int count) {
+    select_kernels()->and_words(destination, left, right, count);
+}
+
+long kernel_popcount(const uint64_t* words, int count) {
+    return select_kernels()->popcount(words, count);
+}
@@ -0,0 +1,739 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/memory.h"
+#include "utils/common.h"
+#include "utils/error.h"
+#include "utils/shape.h"
+#include "utils/tree.h"
+#include "utils/deque.h"
+#include "utils/queue.h"
+#include "utils/bitset.h"
+
+//#define DEBUG
+
+bool memory_collection_requested = false;
+
+byte_t* memory_nursery_start = NULL;
+byte_t* memory_nursery_end = NULL;
+
+static byte_t* nursery_top = NULL;
+
+// nursery objects owning buffers outside of the nursery (array elements, property tables),
+// which have to be released when the objects die in a minor collection
+static heap_header_t** nursery_owners = NULL;
+static int nursery_owner_count = 0;
+static int nursery_owner_capacity = 0;
+
+static heap_header_t** remembered_set = NULL;
+static int remembered_count = 0;
+static int remembered_capacity = 0;
+
+static heap_header_t* objects = NULL;
+static size_t bytes_allocated = 0;
+static size_t next_collection = MEMORY_INITIAL_THRESHOLD;
+
+static heap_header_t** gray_stack = NULL;
+static int gray_count = 0;
+static int gray_capacity = 0;
+
+static bool minor_collection = false;
+
+static char** interned = NULL;
+static int interned_count = 0;
+static int interned_capacity = 0;
+
+static char* characters[256];
+
+static inline heap_header_t* header_of(void* pointer) {
+    return ((heap_header_t*)pointer) - 1;
+}
+
+// string values point past the string prefix, to the characters
+static inline heap_header_t* string_header_of(char* string) {
+    return header_of(string_header(string));
+}
+
+static inline char* string_of(heap_header_t* header) {
+    return (char*)((string_header_t*)(header + 1) + 1);
+}
+
+static inline void account(size_t old_size, size_t new_size) {
+    bytes_allocated += new_size;
+    bytes_allocated -= old_size;
+
+    if (bytes_allocated > next_collection) {
+        memory_collection_requested = true;
+    }
+}
+
+static void push_header(heap_header_t*** headers, int* count, int* capacity, heap_header_t* header) {
+    if (*count == *capacity) {
+        *capacity = *capacity == 0 ? 64 : *capacity * 2;
+        *headers = (heap_header_t**)realloc(*headers, *capacity * sizeof(heap_header_t*));
+
+        if (*headers == NULL) {
+            error_throw(ERROR_RUNTIME, "Failed to allocate memory for the garbage collector", 0);
+        }
+    }
+
+    (*headers)[(*count)++] = header;
+}
+
+static size_t object_size(heap_header_t* header) {
+    switch (header->type) {
+        case HEAP_STRING: return sizeof(string_header_t) + ((string_header_t*)(header + 1))->length + 1;
+        case HEAP_ARRAY: return sizeof(array_t);
+        case HEAP_OBJECT: return sizeof(object_t);
+        case HEAP_ROPE: return sizeof(string_header_t) + sizeof(rope_t);
+        case HEAP_SLICE: return sizeof(string_header_t) + sizeof(slice_t);
+        case HEAP_MAP: return sizeof(map_t);
+        case HEAP_TREE: return sizeof(tree_t);
+        case HEAP_DEQUE: return sizeof(deque_t);
+        case HEAP_QUEUE: return sizeof(queue_t);
+        case HEAP_BITSET: return sizeof(bitset_t);
+        default: return sizeof(enum_t);
+    }
+}
+
+// ALLOCATION
+
+static heap_header_t* allocate_old(size_t size) {
+    heap_header_t* header = (heap_header_t*)malloc(sizeof(heap_header_t) + size);
+
+    if (header == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for a heap object", 0);
+        return NULL;
+    }
+
+    header->next = objects;
+    objects = header;
+
+    account(0, sizeof(heap_header_t) + size);
+
+    return header;
+}
+
+static heap_header_t* allocate_young(size_t size) {
+    if (memory_nursery_start == NULL) {
+        memory_nursery_start = (byte_t*)malloc(NURSERY_SIZE);
+
+        if (memory_nursery_start == NULL) {
+            error_throw(ERROR_RUNTIME, "Failed to allocate memory for the nursery", 0);
+            return NULL;
+        }
+
+        memory_nursery_end = memory_nursery_start + NURSERY_SIZE;
+        nursery_top = memory_nursery_start;
+    }
+
+    // keep every object 8 byte aligned
+    size_t total = (sizeof(heap_header_t) + size + 7) & ~(size_t)7;
+
+    if ((size_t)(memory_nursery_end - nursery_top) < total) {
+        memory_collection_requested = true;
+        return NULL;
+    }
+
+    heap_header_t* header = (heap_header_t*)nursery_top;
+    header->next = NULL;
+    nursery_top += total;
+
+    return header;
+}
+
+void* memory_allocate(heap_type type, size_t size) {
+    heap_header_t* header = size <= NURSERY_MAX_OBJECT_SIZE ? allocate_young(size) : NULL;
+
+    if (header == NULL) {
+        header = allocate_old(size);
+    } else if (type == HEAP_ARRAY || type == HEAP_OBJECT || type == HEAP_ENUM || type == HEAP_MAP || type == HEAP_TREE || type == HEAP_DEQUE || type == HEAP_QUEUE || type == HEAP_BITSET) {
+        push_header(&nursery_owners, &nursery_owner_count, &nursery_owner_capacity, header);
+    }
+
+    header->type = type;
+    header->marked = false;
+    header->remembered = false;
+
+    return header + 1;
+}
+
+void* memory_reallocate(void* pointer, size_t old_size, size_t new_size) {
+    account(old_size, new_size);
+
+    if (new_size == 0) {
+        free(pointer);
+        return NULL;
+    }
+
+    void* result = realloc(pointer, new_size);
+
+    if (result == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to reallocate memory for a heap object", 0);
+        return NULL;
+    }
+
+    return result;
+}
+
+char* memory_allocate_string(size_t length) {
+    string_header_t* header = (string_header_t*)memory_allocate(HEAP_STRING, sizeof(string_header_t) + length + 1);
+    header->length = length;
+    header->hash = 0;
+    header->flags = 0;
+
+    char* string = (char*)(header + 1);
+    string[length] = '\0';
+    return string;
+}
+
+char* memory_copy_string(const char* chars, size_t length) {
+    char* string = memory_allocate_string(length);
+    memcpy(string, chars, length);
+    return string;
+}
+
+// INTERNING
+
+unsigned long memory_hash_chars(const char* chars, size_t length) {
+    unsigned long hash = 5381;
+
+    for (size_t i = 0; i < length; i++) {
+        hash = ((hash << 5) + hash) + (unsigned char)chars[i];
+    }
+
+    return hash;
+}
+
+static char** find_interned(char** entries, int capacity, const char* chars, size_t length, unsigned long hash) {
+    size_t index = hash & (capacity - 1);
+
+    while (true) {
+        char** entry = &entries[index];
+
+        if (*entry == NULL) {
+            return entry;
+        }
+
+        string_header_t* header = string_header(*entry);
+
+        if (header->hash == hash && header->length == length && memcmp(*entry, chars, length) == 0) {
+            return entry;
+        }
+
+        index = (index + 1) & (capacity - 1);
+    }
+}
+
+static void grow_interned() {
+    int capacity = interned_capacity == 0 ? 256 : interned_capacity * 2;
+    char** entries = (char**)calloc(capacity, sizeof(char*));
+
+    if (entries == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for the string intern table", 0);
+    }
+
+    for (int i = 0; i < interned_capacity; i++) {
+        if (interned[i] != NULL) {
+            string_header_t* header = string_header(interned[i]);
+            *find_interned(entries, capacity, interned[i], header->length, header->hash) = interned[i];
+        }
+    }
+
+    free(interned);
+    interned = entries;
+    interned_capacity = capacity;
+}
+
+char* memory_intern_string(const char* chars, size_t length) {
+    if ((interned_count + 1) * 4 > interned_capacity * 3) {
+        grow_interned();
+    }
+
+    unsigned long hash = memory_hash_chars(chars, length);
+    char** entry = find_interned(interned, interned_capacity, chars, length, hash);
+
+    if (*entry != NULL) {
+        return *entry;
+    }
+
+    heap_header_t* header = (heap_header_t*)malloc(sizeof(heap_header_t) + sizeof(string_header_t) + length + 1);
+
+    if (header == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for an interned string", 0);
+        return NULL;
+    }
+
+    // interned strings live outside of both generations and are never traced, moved nor swept
+    header->next = NULL;
+    header->type = HEAP_STRING;
+    header->marked = true;
+    header->remembered = false;
+
+    string_header_t* prefix = (string_header_t*)(header + 1);
+    prefix->length = length;
+    prefix->hash = hash;
+    prefix->flags = STRING_INTERNED | STRING_HASHED;
+
+    char* string = (char*)(prefix + 1);
+    memcpy(string, chars, length);
+    string[length] = '\0';
+
+    *entry = string;
+    interned_count++;
+
+    return string;
+}
+
+char* memory_character_string(char character) {
+    unsigned char index = (unsigned char)character;
+
+    if (characters[index] == NULL) {
+        characters[index] = memory_intern_string(&character, 1);
+    }
+
+    return characters[index];
+}
+
+void memory_remember(void* container) {
+    heap_header_t* header = header_of(container);
+
+    if (!header->remembered) {
+        header->remembered = true;
+        push_header(&remembered_set, &remembered_count, &remembered_capacity, header);
+    }
+}
+
+// RELEASING
+
+static void free_buffers(heap_header_t* header) {
+    switch (header->type) {
+        case HEAP_ARRAY: {
+            array_t* array = (array_t*)(header + 1);
+            memory_reallocate(array->elements.values, array->capacity * array_element_size(array->kind), 0);
+            break;
+        }
+        case HEAP_OBJECT: {
+            object_t* object = (object_t*)(header + 1);
+            memory_reallocate(object->slots, object->capacity * sizeof(value_t), 0);
+            break;
+        }
+        case HEAP_ENUM: {
+            enum_t* enumeration = (enum_t*)(header + 1);
+            table_free(enumeration->values);
+            free(enumeration->values);
+            break;
+        }
+        case HEAP_MAP: {
+            map_t* map = (map_t*)(header + 1);
+            memory_reallocate(map->entries, map->capacity * sizeof(map_entry_t), 0);
+            memory_reallocate(map->buckets, map->capacity * 2 * sizeof(int), 0);
+            break;
+        }
+        case HEAP_TREE: {
+            tree_free_nodes((tree_t*)(header + 1));
+            break;
+        }
+        case HEAP_DEQUE: {
+            deque_t* deque = (deque_t*)(header + 1);
+            memory_reallocate(deque->values, deque->capacity * sizeof(value_t), 0);
+            break;
+        }
+        case HEAP_QUEUE: {
+            queue_t* queue = (queue_t*)(header + 1);
+            memory_reallocate(queue->priorities, queue->capacity * sizeof(number_t), 0);
+            memory_reallocate(queue->values, queue->capacity * sizeof(value_t), 0);
+            break;
+        }
+        case HEAP_BITSET: {
+            bitset_t* bitset = (bitset_t*)(header + 1);
+            memory_reallocate(bitset->words, BITSET_WORDS(bitset->size) * sizeof(uint64_t), 0);
+            break;
+        }
+    }
+}
+
+static void free_heap_object(heap_header_t* header) {
+    account(sizeof(heap_header_t) + object_size(header), 0);
+    free_buffers(header);
+    free(header);
+}
+
+// MINOR COLLECTION
+
+static heap_header_t* promote(heap_header_t* header) {
+    // already promoted, next holds the forwarding address
+    if (header->marked) {
+        return header->next;
+    }
+
+    size_t size = object_size(header);
+    heap_header_t* copy = allocate_old(size);
+
+    heap_header_t* next = copy->next;
+
+    memcpy(copy, header, sizeof(heap_header_t) + size);
+    copy->next = next;
+    copy->marked = false;
+    copy->remembered = false;
+
+    header->marked = true;
+    header->next = copy;
+
+    // the copy still references the nursery, so its references are forwarded later
+    if (copy->type != HEAP_STRING) {
+        push_header(&gray_stack, &gray_count, &gray_capacity, copy);
+    }
+
+    return copy;
+}
+
+static void forward_value(value_t* slot) {
+    value_t value = *slot;
+
+    switch (value_get_type(value)) {
+        case TYPE_STRING: {
+            if (memory_in_nursery(AS_STRING(value))) {
+                *slot = STRING_VALUE(string_of(promote(string_header_of(AS_STRING(value)))));
+            }
+            break;
+        }
+        case TYPE_ARRAY: {
+            if (memory_in_nursery(AS_ARRAY(value))) {
+                *slot = ARRAY_VALUE((array_t*)(promote(header_of(AS_ARRAY(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_OBJECT: {
+            if (memory_in_nursery(AS_OBJECT(value))) {
+                *slot = OBJECT_VALUE((object_t*)(promote(header_of(AS_OBJECT(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_ENUM: {
+            if (memory_in_nursery(AS_ENUM(value))) {
+                *slot = ENUM_VALUE((enum_t*)(promote(header_of(AS_ENUM(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_MAP: {
+            if (memory_in_nursery(AS_MAP(value))) {
+                *slot = MAP_VALUE((map_t*)(promote(header_of(AS_MAP(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_TREE: {
+            if (memory_in_nursery(AS_TREE(value))) {
+                *slot = TREE_VALUE((tree_t*)(promote(header_of(AS_TREE(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_DEQUE: {
+            if (memory_in_nursery(AS_DEQUE(value))) {
+                *slot = DEQUE_VALUE((deque_t*)(promote(header_of(AS_DEQUE(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_QUEUE: {
+            if (memory_in_nursery(AS_QUEUE(value))) {
+                *slot = QUEUE_VALUE((queue_t*)(promote(header_of(AS_QUEUE(value))) + 1));
+            }
+            break;
+        }
+        case TYPE_BITSET: {
+            if (memory_in_nursery(AS_BITSET(value))) {
+                *slot = BITSET_VALUE((bitset_t*)(promote(header_of(AS_BITSET(value))) + 1));
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+static void forward_table(table_t* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->entries[i].key != NULL) {
+            forward_value(&table->entries[i].value);
+        }
+    }
+}
+
+static void forward_references(heap_header_t* header) {
+    switch (header->type) {
+        case HEAP_ARRAY: {
+            array_t* array = (array_t*)(header + 1);
+
+            // packed arrays hold no references
+            if (array->kind != ARRAY_VALUES) {
+                break;
+            }
+
+            for (int i = 0; i < array->size; i++) {
+                forward_value(&array->elements.values[i]);
+            }
+
+            break;
+        }
+        case HEAP_OBJECT: {
+            object_t* object = (object_t*)(header + 1);
+
+            for (int i = 0; i < object->shape->count; i++) {
+                forward_value(&object->slots[i]);
+            }
+
+            break;
+        }
+        case HEAP_ENUM: {
+            forward_table(((enum_t*)(header + 1))->values);
+            break;
+        }
+        case HEAP_ROPE: {
+            rope_t* rope = (rope_t*)((string_header_t*)(header + 1) + 1);
+            forward_value(&rope->left);
+            forward_value(&rope->right);
+            break;
+        }
+        case HEAP_SLICE: {
+            forward_value(&((slice_t*)((string_header_t*)(header + 1) + 1))->parent);
+            break;
+        }
+        case HEAP_MAP: {
+            map_t* map = (map_t*)(header + 1);
+
+            for (int i = 0; i < map->count; i++) {
+                forward_value(&map->entries[i].key);
+                forward_value(&map->entries[i].value);
+            }
+
+            break;
+        }
+        case HEAP_TREE: {
+            tree_visit_slots((tree_t*)(header + 1), forward_value);
+            break;
+        }
+        case HEAP_DEQUE: {
+            deque_t* deque = (deque_t*)(header + 1);
+
+            for (int i = 0; i < deque->count; i++) {
+                forward_value(deque_at(deque, i));
+            }
+
+            break;
+        }
+        case HEAP_QUEUE: {
+            queue_t* queue = (queue_t*)(header + 1);
+
+            for (int i = 0; i < queue->count; i++) {
+                forward_value(&queue->values[i]);
+            }
+
+            break;
+        }
+    }
+}
+
+static void collect_minor(void (*mark_roots)()) {
+    minor_collection = true;
+    mark_roots();
+    minor_collection = false;
+
+    for (int i = 0; i < remembered_count; i++) {
+        remembered_set[i]->remembered = false;
+        forward_references(remembered_set[i]);
+    }
+
+    remembered_count = 0;
+
+    while (gray_count > 0) {
+        forward_references(gray_stack[--gray_count]);
+    }
+
+    // promoted objects handed their buffers over to their copies, the rest are dead
+    for (int i = 0; i < nursery_owner_count; i++) {
+        if (!nursery_owners[i]->marked) {
+            free_buffers(nursery_owners[i]);
+        }
+    }
+
+    nursery_owner_count = 0;
+    nursery_top = memory_nursery_start;
+}
+
+// MAJOR COLLECTION
+
+static void mark_value(value_t value) {
+    heap_header_t* header;
+
+    switch (value_get_type(value)) {
+        case TYPE_STRING: header = string_header_of(AS_STRING(value)); break;
+        case TYPE_ARRAY: header = header_of(AS_ARRAY(value)); break;
+        case TYPE_OBJECT: header = header_of(AS_OBJECT(value)); break;
+        case TYPE_ENUM: header = header_of(AS_ENUM(value)); break;
+        case TYPE_MAP: header = header_of(AS_MAP(value)); break;
+        case TYPE_TREE: header = header_of(AS_TREE(value)); break;
+        case TYPE_DEQUE: header = header_of(AS_DEQUE(value)); break;
+        case TYPE_QUEUE: header = header_of(AS_QUEUE(value)); break;
+        case TYPE_BITSET: header = header_of(AS_BITSET(value)); break;
+        default: return;
+    }
+
+    if (header->marked) {
+        return;
+    }
+
+    header->marked = true;
+
+    // strings and bitsets have no references, so they never need to be traced
+    if (header->type != HEAP_STRING && header->type != HEAP_BITSET) {
+        push_header(&gray_stack, &gray_count, &gray_capacity, header);
+    }
+}
+
+static void mark_slot(value_t* slot) {
+    mark_value(*slot);
+}
+
+void memory_mark_values(value_t* values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (minor_collection) {
+            forward_value(&values[i]);
+        } else {
+            mark_value(values[i]);
+        }
+    }
+}
+
+static void mark_table(table_t* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->entries[i].key != NULL) {
+            mark_value(table->entries[i].value);
+        }
+    }
+}
+
+static void trace_references() {
+    while (gray_count > 0) {
+        heap_header_t* header = gray_stack[--gray_count];
+
+        switch (header->type) {
+            case HEAP_ARRAY: {
+                array_t* array = (array_t*)(header + 1);
+
+                if (array->kind != ARRAY_VALUES) {
+                    break;
+                }
+
+                for (int i = 0; i < array->size; i++) {
+                    mark_value(array->elements.values[i]);
+                }
+
+                break;
+            }
+            case HEAP_OBJECT: {
+                object_t* object = (object_t*)(header + 1);
+
+                for (int i = 0; i < object->shape->count; i++) {
+                    mark_value(object->slots[i]);
+                }
+
+                break;
+            }
+            case HEAP_ENUM: {
+                mark_table(((enum_t*)(header + 1))->values);
+                break;
+            }
+            case HEAP_ROPE: {
+                rope_t* rope = (rope_t*)((string_header_t*)(header + 1) + 1);
+                mark_value(rope->left);
+                mark_value(rope->right);
+                break;
+            }
+            case HEAP_SLICE: {
+                mark_value(((slice_t*)((string_header_t*)(header + 1) + 1))->parent);
+                break;
+            }
+            case HEAP_MAP: {
+                map_t* map = (map_t*)(header + 1);
+
+                for (int i = 0; i < map->count; i++) {
+                    mark_value(map->entries[i].key);
+                    mark_value(map->entries[i].value);
+                }
+
+                break;
+            }
+            case HEAP_TREE: {
+                tree_visit_slots((tree_t*)(header + 1), mark_slot);
+                break;
+            }
+            case HEAP_DEQUE: {
+                deque_t* deque = (deque_t*)(header + 1);
+
+                for (int i = 0; i < deque->count; i++) {
+                    mark_value(*deque_at(deque, i));
+                }
+
+                break;
+            }
+            case HEAP_QUEUE: {
+                queue_t* queue = (queue_t*)(header + 1);
+
+                for (int i = 0; i < queue->count; i++) {
+                    mark_value(queue->values[i]);
+                }
+
+                break;
+            }
+        }
+    }
+}
+
+static void sweep() {
+    heap_header_t** current = &objects;
+
+    while (*current != NULL) {
+        heap_header_t* header = *current;
+
+        if (header->marked) {
+            header->marked = false;
+            current = &header->next;
+        } else {
+            *current = header->next;
+            free_heap_object(header);
+        }
+    }
+}
+
+static void collect_major(void (*mark_roots)()) {
+    mark_roots();
+    trace_references();
+    sweep();
+
+    next_collection = bytes_allocated * MEMORY_GROWTH_FACTOR;
+
+    if (next_collection < MEMORY_INITIAL_THRESHOLD) {
+        next_collection = MEMORY_INITIAL_THRESHOLD;
+    }
+}
+
+void memory_collect(void (*mark_roots)()) {
+    #ifdef DEBUG
+    size_t before = bytes_allocated;
+    #endif
+
+    collect_minor(mark_roots);
+
+    // the nursery is empty after a minor collection, so only the old generation is left to collect
+    if (bytes_allocated > next_collection) {
+        collect_major(mark_roots);
+    }
+
+    memory_collection_requested = false;
+
+    #ifdef DEBUG
+    printf("Collected garbage, old generation went from %zu to %zu bytes, next major collection at %zu\n", before, bytes_allocated, next_collection);
+    #endif
+}
@@ -0,0 +1,90 @@
+#include "utils/queue.h"
+#include "utils/memory.h"
+
+queue_t* queue_init() {
+    queue_t* queue = (queue_t*)memory_allocate(HEAP_QUEUE, sizeof(queue_t));
+    queue->count = 0;
+    queue->capacity = QUEUE_MIN_CAPACITY;
+    queue->priorities = (number_t*)memory_reallocate(NULL, 0, QUEUE_MIN_CAPACITY * sizeof(number_t));
+    queue->values = (value_t*)memory_reallocate(NULL, 0, QUEUE_MIN_CAPACITY * sizeof(value_t));
+    return queue;
+}
+
+static void queue_resize(queue_t* queue, int capacity) {
+    queue->priorities = (number_t*)memory_reallocate(queue->priorities, queue->capacity * sizeof(number_t), capacity * sizeof(number_t));
+    queue->values = (value_t*)memory_reallocate(queue->values, queue->capacity * sizeof(value_t), capacity * sizeof(value_t));
+    queue->capacity = capacity;
+}
+
+// the moving entry is held aside while the entries on its path shift into the hole it leaves
+void queue_push(queue_t* queue, number_t priority, value_t value) {
+    if (queue->count == queue->capacity) {
+        queue_resize(queue, queue->capacity * 2);
+    }
+
+    int index = queue->count++;
+
+    while (index > 0) {
+        int parent = (index - 1) / QUEUE_ARITY;
+
+        if (queue->priorities[parent] <= priority) {
+            break;
+        }
+
+        queue->priorities[index] = queue->priorities[parent];
+        queue->values[index] = queue->values[parent];
+        index = parent;
+    }
+
+    queue->priorities[index] = priority;
+    queue->values[index] = value;
+
+    value_retain(value);
+    memory_write_barrier(queue, value);
+}
+
+value_t queue_pop(queue_t* queue) {
+    value_t result = queue->values[0];
+    value_release(result);
+
+    int count = --queue->count;
+    number_t priority = queue->priorities[count];
+    value_t value = queue->values[count];
+    int index = 0;
+
+    // the last entry sinks from the root, swapping with its smallest child
+    while (true) {
+        int first = QUEUE_ARITY * index + 1;
+
+        if (first >= count) {
+            break;
+        }
+
+        int last = first + QUEUE_ARITY < count ? first + QUEUE_ARITY : count;
+        int smallest = first;
+
+        for (int child = first + 1; child < last; child++) {
+            if (queue->priorities[child] < queue->priorities[smallest]) {
+                smallest = child;
+            }
+        }
+
+        if (queue->priorities[smallest] >= priority) {
+            break;
+        }
+
+        queue->priorities[index] = queue->priorities[smallest];
+        queue->values[index] = queue->values[smallest];
+        index = smallest;
+    }
+
+    queue->priorities[index] = priority;
+    queue->values[index] = value;
+
+    // shrinking only below a quarter keeps alternating pushes and pops from resizing every time
+    if (count < queue->capacity / 4 && queue->capacity > QUEUE_MIN_CAPACITY) {
+        queue_resize(queue, queue->capacity / 2);
+    }
+
+    return result;
+}
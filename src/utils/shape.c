@@ -0,0 +1,56 @@
+#include <stdlib.h>
+
+#include "utils/shape.h"
+#include "utils/error.h"
+
+static shape_t* root = NULL;
+
+static shape_t* shape_init(shape_t* parent, char* name) {
+    shape_t* shape = (shape_t*)malloc(sizeof(shape_t));
+
+    if (shape == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for an object shape", 0);
+        return NULL;
+    }
+
+    shape->parent = parent;
+    shape->name = name;
+    shape->slot = parent == NULL ? -1 : parent->count;
+    shape->count = parent == NULL ? 0 : parent->count + 1;
+    shape->transitions = NULL;
+    shape->sibling = NULL;
+
+    return shape;
+}
+
+shape_t* shape_root() {
+    if (root == NULL) {
+        root = shape_init(NULL, NULL);
+    }
+
+    return root;
+}
+
+int shape_lookup(shape_t* shape, const char* name) {
+    for (; shape->parent != NULL; shape = shape->parent) {
+        if (shape->name == name) {
+            return shape->slot;
+        }
+    }
+
+    return -1;
+}
+
+shape_t* shape_transition(shape_t* shape, char* name) {
+    for (shape_t* transition = shape->transitions; transition != NULL; transition = transition->sibling) {
+        if (transition->name == name) {
+            return transition;
+        }
+    }
+
+    shape_t* transition = shape_init(shape, name);
+    transition->sibling = shape->transitions;
+    shape->transitions = transition;
+
+    return transition;
+}
@@ -0,0 +1,275 @@
+#include <string.h>
+
+#include "utils/tree.h"
+#include "utils/memory.h"
+
+// numbers are ordered before strings, strings by their bytes and then by their length
+static int compare_keys(value_t left, value_t right) {
+    if (IS_NUMBER(left) && IS_NUMBER(right)) {
+        number_t left_number = AS_NUMBER(left);
+        number_t right_number = AS_NUMBER(right);
+        return left_number < right_number ? -1 : left_number > right_number;
+    }
+
+    if (IS_NUMBER(left) != IS_NUMBER(right)) {
+        return IS_NUMBER(left) ? -1 : 1;
+    }
+
+    size_t left_length = string_length(AS_STRING(left));
+    size_t right_length = string_length(AS_STRING(right));
+    int result = memcmp(string_chars(AS_STRING(left)), string_chars(AS_STRING(right)), left_length < right_length ? left_length : right_length);
+
+    if (result != 0) {
+        return result;
+    }
+
+    return left_length < right_length ? -1 : left_length > right_length;
+}
+
+// returns the index of the first key of a node not smaller than the key
+static int lower_bound(tree_node_t* node, value_t key) {
+    int low = 0;
+    int high = node->count;
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+
+        if (compare_keys(node->keys[middle], key) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static inline size_t node_size(bool leaf) {
+    return leaf ? offsetof(tree_node_t, children) : sizeof(tree_node_t);
+}
+
+static tree_node_t* node_init(bool leaf) {
+    tree_node_t* node = (tree_node_t*)memory_reallocate(NULL, 0, node_size(leaf));
+    node->count = 0;
+    node->leaf = leaf;
+    return node;
+}
+
+tree_t* tree_init() {
+    tree_t* tree = (tree_t*)memory_allocate(HEAP_TREE, sizeof(tree_t));
+    tree->root = node_init(true);
+    tree->count = 0;
+    return tree;
+}
+
+value_t* tree_get(tree_t* tree, value_t key) {
+    tree_node_t* node = tree->root;
+
+    while (true) {
+        int index = lower_bound(node, key);
+
+        if (index < node->count && compare_keys(node->keys[index], key) == 0) {
+            return &node->values[index];
+        }
+
+        if (node->leaf) {
+            return NULL;
+        }
+
+        node = node->children[index];
+    }
+}
+
+// moves the upper half of a full child into a new sibling, and its middle entry up into the parent
+static void split_child(tree_node_t* parent, int index) {
+    tree_node_t* child = parent->children[index];
+    tree_node_t* sibling = node_init(child->leaf);
+    sibling->count = TREE_MIN_DEGREE - 1;
+
+    memcpy(sibling->keys, child->keys + TREE_MIN_DEGREE, sibling->count * sizeof(value_t));
+    memcpy(sibling->values, child->values + TREE_MIN_DEGREE, sibling->count * sizeof(value_t));
+
+    if (!child->leaf) {
+        memcpy(sibling->children, child->children + TREE_MIN_DEGREE, TREE_MIN_DEGREE * sizeof(tree_node_t*));
+    }
+
+    child->count = TREE_MIN_DEGREE - 1;
+
+    memmove(parent->keys + index + 1, parent->keys + index, (parent->count - index) * sizeof(value_t));
+    memmove(parent->values + index + 1, parent->values + index, (parent->count - index) * sizeof(value_t));
+    memmove(parent->children + index + 2, parent->children + index + 1, (parent->count - index) * sizeof(tree_node_t*));
+
+    parent->keys[index] = child->keys[TREE_MIN_DEGREE - 1];
+    parent->values[index] = child->values[TREE_MIN_DEGREE - 1];
+    parent->children[index + 1] = sibling;
+    parent->count++;
+}
+
+void tree_set(tree_t* tree, value_t key, value_t value) {
+    value_t* slot = tree_get(tree, key);
+
+    if (slot != NULL) {
+        value_store(slot, value);
+        memory_write_barrier(tree, value);
+        return;
+    }
+
+    // full nodes are split on the way down, so the leaf receiving the key always has room for it
+    if (tree->root->count == TREE_MAX_KEYS) {
+        tree_node_t* root = node_init(false);
+        root->children[0] = tree->root;
+        tree->root = root;
+        split_child(root, 0);
+    }
+
+    tree_node_t* node = tree->root;
+
+    while (!node->leaf) {
+        int index = lower_bound(node, key);
+
+        if (node->children[index]->count == TREE_MAX_KEYS) {
+            split_child(node, index);
+
+            if (compare_keys(node->keys[index], key) < 0) {
+                index++;
+            }
+        }
+
+        node = node->children[index];
+    }
+
+    int index = lower_bound(node, key);
+
+    memmove(node->keys + index + 1, node->keys + index, (node->count - index) * sizeof(value_t));
+    memmove(node->values + index + 1, node->values + index, (node->count - index) * sizeof(value_t));
+
+    node->keys[index] = key;
+    node->values[index] = value;
+    node->count++;
+    tree->count++;
+
+    value_retain(value);
+    memory_write_barrier(tree, key);
+    memory_write_barrier(tree, value);
+}
+
+value_t* tree_floor(tree_t* tree, value_t key) {
+    tree_node_t* node = tree->root;
+    value_t* result = NULL;
+
+    while (true) {
+        int index = lower_bound(node, key);
+
+        if (index < node->count && compare_keys(node->keys[index], key) == 0) {
+            return &node->keys[index];
+        }
+
+        // keys of the child at index are larger than the key before index, so it is the best candidate so far
+        if (index > 0) {
+            result = &node->keys[index - 1];
+        }
+
+        if (node->leaf) {
+            return result;
+        }
+
+        node = node->children[index];
+    }
+}
+
+value_t* tree_ceiling(tree_t* tree, value_t key) {
+    tree_node_t* node = tree->root;
+    value_t* result = NULL;
+
+    while (true) {
+        int index = lower_bound(node, key);
+
+        if (index < node->count) {
+            if (compare_keys(node->keys[index], key) == 0) {
+                return &node->keys[index];
+            }
+
+            result = &node->keys[index];
+        }
+
+        if (node->leaf) {
+            return result;
+        }
+
+        node = node->children[index];
+    }
+}
+
+// returns false once a key above the range has been reached, which ends the walk
+static bool walk_range(tree_node_t* node, value_t low, value_t high, void (*callback)(value_t key, value_t value, void* context), void* context) {
+    for (int i = lower_bound(node, low); i <= node->count; i++) {
+        if (!node->leaf && !walk_range(node->children[i], low, high, callback, context)) {
+            return false;
+        }
+
+        if (i == node->count) {
+            break;
+        }
+
+        if (compare_keys(node->keys[i], high) > 0) {
+            return false;
+        }
+
+        callback(node->keys[i], node->values[i], context);
+    }
+
+    return true;
+}
+
+void tree_range(tree_t* tree, value_t low, value_t high, void (*callback)(value_t key, value_t value, void* context), void* context) {
+    walk_range(tree->root, low, high, callback, context);
+}
+
+static void walk(tree_node_t* node, void (*callback)(value_t key, value_t value, void* context), void* context) {
+    for (int i = 0; i < node->count; i++) {
+        if (!node->leaf) {
+            walk(node->children[i], callback, context);
+        }
+
+        callback(node->keys[i], node->values[i], context);
+    }
+
+    if (!node->leaf) {
+        walk(node->children[node->count], callback, context);
+    }
+}
+
+void tree_for_each(tree_t* tree, void (*callback)(value_t key, value_t value, void* context), void* context) {
+    walk(tree->root, callback, context);
+}
+
+static void visit_node(tree_node_t* node, void (*visit)(value_t* slot)) {
+    for (int i = 0; i < node->count; i++) {
+        visit(&node->keys[i]);
+        visit(&node->values[i]);
+    }
+
+    if (!node->leaf) {
+        for (int i = 0; i <= node->count; i++) {
+            visit_node(node->children[i], visit);
+        }
+    }
+}
+
+void tree_visit_slots(tree_t* tree, void (*visit)(value_t* slot)) {
+    visit_node(tree->root, visit);
+}
+
+static void free_node(tree_node_t* node) {
+    if (!node->leaf) {
+        for (int i = 0; i <= node->count; i++) {
+            free_node(node->children[i]);
+        }
+    }
+
+    memory_reallocate(node, node_size(node->leaf), 0);
+}
+
+void tree_free_nodes(tree_t* tree) {
+    free_node(tree->root);
+}
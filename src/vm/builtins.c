@@ -0,0 +1,443 @@
+#include "vm/builtins.h"
+#include "vm/natives.h"
+#include "utils/error.h"
+#include "utils/kernels.h"
+#include "utils/tree.h"
+#include "utils/deque.h"
+#include "utils/queue.h"
+#include "utils/bitset.h"
+
+// arrays of values holding numbers only are packed, so that the kernels can read them in place
+static array_t* numbers_argument(value_t value, char* error_string, int line) {
+    if (!IS_ARRAY(value) || !array_pack_numbers(AS_ARRAY(value))) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    return AS_ARRAY(value);
+}
+
+static value_t builtin_sum(value_t* args, int line) {
+    array_t* array = numbers_argument(args[0], "Expected an array of numbers in sum()", line);
+    return NUMBER_VALUE(kernel_sum(array->elements.numbers, array->size));
+}
+
+static value_t builtin_min(value_t* args, int line) {
+    array_t* array = numbers_argument(args[0], "Expected an array of numbers in min()", line);
+
+    if (array->size == 0) {
+        error_throw(ERROR_RUNTIME, "Expected a non-empty array in min()", line);
+    }
+
+    return NUMBER_VALUE(kernel_min(array->elements.numbers, array->size));
+}
+
+static value_t builtin_max(value_t* args, int line) {
+    array_t* array = numbers_argument(args[0], "Expected an array of numbers in max()", line);
+
+    if (array->size == 0) {
+        error_throw(ERROR_RUNTIME, "Expected a non-empty array in max()", line);
+    }
+
+    return NUMBER_VALUE(kernel_max(array->elements.numbers, array->size));
+}
+
+static value_t builtin_dot(value_t* args, int line) {
+    array_t* left = numbers_argument(args[0], "Expected arrays of numbers in dot()", line);
+    array_t* right = numbers_argument(args[1], "Expected arrays of numbers in dot()", line);
+
+    if (left->size != right->size) {
+        error_throw(ERROR_RUNTIME, "Expected arrays of the same size in dot()", line);
+    }
+
+    return NUMBER_VALUE(kernel_dot(left->elements.numbers, right->elements.numbers, left->size));
+}
+
+static value_t builtin_scale(value_t* args, int line) {
+    array_t* array = numbers_argument(args[0], "Expected an array of numbers in scale()", line);
+
+    if (!IS_NUMBER(args[1])) {
+        error_throw(ERROR_RUNTIME, "Expected the factor of scale() to be a number", line);
+    }
+
+    array_t* result = array_init(array->size, ARRAY_NUMBERS);
+    kernel_scale(result->elements.numbers, array->elements.numbers, AS_NUMBER(args[1]), array->size);
+
+    return ARRAY_VALUE(result);
+}
+
+static value_t builtin_fill(value_t* args, int line) {
+    if (!IS_NUMBER(args[0]) || AS_NUMBER(args[0]) < 0) {
+        error_throw(ERROR_RUNTIME, "Expected the size in fill() to be a non-negative number", line);
+    }
+
+    int size = (int)AS_NUMBER(args[0]);
+    value_t value = args[1];
+    array_t* array = array_init(size, array_kind_of(value));
+
+    if (array->kind == ARRAY_NUMBERS) {
+        kernel_fill(array->elements.numbers, AS_NUMBER(value), size);
+        return ARRAY_VALUE(array);
+    }
+
+    for (int i = 0; i < size; i++) {
+        array_add_element(array, i, value);
+        value_retain(value);
+    }
+
+    return ARRAY_VALUE(array);
+}
+
+static map_t* map_argument(value_t value, char* error_string, int line) {
+    if (!IS_MAP(value)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    return AS_MAP(value);
+}
+
+static tree_t* tree_argument(value_t value, char* error_string, int line) {
+    if (!IS_TREE(value)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    return AS_TREE(value);
+}
+
+static void check_tree_key(value_t key, int line) {
+    if (!tree_is_key(key)) {
+        error_throw(ERROR_RUNTIME, "Expected ordered map keys to be numbers or strings", line);
+    }
+}
+
+static void check_map_key(value_t key, int line) {
+    if (!map_is_key(key)) {
+        error_throw(ERROR_RUNTIME, "Expected map keys to be numbers, booleans or strings", line);
+    }
+}
+
+static void append_key(value_t key, value_t value, void* context) {
+    array_append((array_t*)context, key);
+}
+
+static void append_value(value_t key, value_t value, void* context) {
+    array_append((array_t*)context, value);
+}
+
+static value_t builtin_keys(value_t* args, int line) {
+    array_t* array = array_init(0, ARRAY_NUMBERS);
+
+    if (IS_TREE(args[0])) {
+        tree_for_each(AS_TREE(args[0]), append_key, array);
+        return ARRAY_VALUE(array);
+    }
+
+    map_t* map = map_argument(args[0], "Expected a map or an ordered map in keys()", line);
+
+    for (int i = 0; i < map->count; i++) {
+        array_append(array, map->entries[i].key);
+    }
+
+    return ARRAY_VALUE(array);
+}
+
+static value_t builtin_values(value_t* args, int line) {
+    array_t* array = array_init(0, ARRAY_NUMBERS);
+
+    if (IS_TREE(args[0])) {
+        tree_for_each(AS_TREE(args[0]), append_value, array);
+        return ARRAY_VALUE(array);
+    }
+
+    map_t* map = map_argument(args[0], "Expected a map or an ordered map in values()", line);
+
+    for (int i = 0; i < map->count; i++) {
+        array_append(array, map->entries[i].value);
+    }
+
+    return ARRAY_VALUE(array);
+}
+
+static value_t builtin_has(value_t* args, int line) {
+    if (IS_TREE(args[0])) {
+        check_tree_key(args[1], line);
+        return BOOLEAN_VALUE(tree_get(AS_TREE(args[0]), args[1]) != NULL);
+    }
+
+    map_t* map = map_argument(args[0], "Expected a map or an ordered map in has()", line);
+    check_map_key(args[1], line);
+
+    return BOOLEAN_VALUE(map_get(map, args[1]) != NULL);
+}
+
+static value_t builtin_tree(value_t* args, int line) {
+    return TREE_VALUE(tree_init());
+}
+
+static value_t builtin_insert(value_t* args, int line) {
+    tree_t* tree = tree_argument(args[0], "Expected an ordered map in insert()", line);
+    check_tree_key(args[1], line);
+
+    tree_set(tree, args[1], args[2]);
+    return args[0];
+}
+
+static value_t builtin_lookup(value_t* args, int line) {
+    tree_t* tree = tree_argument(args[0], "Expected an ordered map in lookup()", line);
+    check_tree_key(args[1], line);
+
+    value_t* value = tree_get(tree, args[1]);
+
+    if (value == NULL) {
+        error_throw(ERROR_RUNTIME, "Key not found in ordered map", line);
+    }
+
+    return *value;
+}
+
+// GEN has no null, so the bound searches return the given fallback when no key qualifies
+static value_t builtin_floor_key(value_t* args, int line) {
+    tree_t* tree = tree_argument(args[0], "Expected an ordered map in floor_key()", line);
+    check_tree_key(args[1], line);
+
+    value_t* key = tree_floor(tree, args[1]);
+    return key == NULL ? args[2] : *key;
+}
+
+static value_t builtin_ceiling_key(value_t* args, int line) {
+    tree_t* tree = tree_argument(args[0], "Expected an ordered map in ceiling_key()", line);
+    check_tree_key(args[1], line);
+
+    value_t* key = tree_ceiling(tree, args[1]);
+    return key == NULL ? args[2] : *key;
+}
+
+static value_t builtin_range_keys(value_t* args, int line) {
+    tree_t* tree = tree_argument(args[0], "Expected an ordered map in range_keys()", line);
+    check_tree_key(args[1], line);
+    check_tree_key(args[2], line);
+
+    array_t* array = array_init(0, ARRAY_NUMBERS);
+    tree_range(tree, args[1], args[2], append_key, array);
+
+    return ARRAY_VALUE(array);
+}
+
+static value_t builtin_range_values(value_t* args, int line) {
+    tree_t* tree = tree_argument(args[0], "Expected an ordered map in range_values()", line);
+    check_tree_key(args[1], line);
+    check_tree_key(args[2], line);
+
+    array_t* array = array_init(0, ARRAY_NUMBERS);
+    tree_range(tree, args[1], args[2], append_value, array);
+
+    return ARRAY_VALUE(array);
+}
+
+static deque_t* deque_argument(value_t value, char* error_string, int line) {
+    if (!IS_DEQUE(value)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    return AS_DEQUE(value);
+}
+
+static void check_not_empty(deque_t* deque, char* error_string, int line) {
+    if (deque->count == 0) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+}
+
+static value_t builtin_deque(value_t* args, int line) {
+    return DEQUE_VALUE(deque_init());
+}
+
+static value_t builtin_push_back(value_t* args, int line) {
+    deque_push_back(deque_argument(args[0], "Expected a deque in push_back()", line), args[1]);
+    return args[0];
+}
+
+static value_t builtin_push_front(value_t* args, int line) {
+    deque_push_front(deque_argument(args[0], "Expected a deque in push_front()", line), args[1]);
+    return args[0];
+}
+
+static value_t builtin_pop_back(value_t* args, int line) {
+    deque_t* deque = deque_argument(args[0], "Expected a deque in pop_back()", line);
+    check_not_empty(deque, "Expected a non-empty deque in pop_back()", line);
+
+    return deque_pop_back(deque);
+}
+
+static value_t builtin_pop_front(value_t* args, int line) {
+    deque_t* deque = deque_argument(args[0], "Expected a deque in pop_front()", line);
+    check_not_empty(deque, "Expected a non-empty deque in pop_front()", line);
+
+    return deque_pop_front(deque);
+}
+
+static value_t builtin_front(value_t* args, int line) {
+    deque_t* deque = deque_argument(args[0], "Expected a deque in front()", line);
+    check_not_empty(deque, "Expected a non-empty deque in front()", line);
+
+    return *deque_at(deque, 0);
+}
+
+static value_t builtin_back(value_t* args, int line) {
+    deque_t* deque = deque_argument(args[0], "Expected a deque in back()", line);
+    check_not_empty(deque, "Expected a non-empty deque in back()", line);
+
+    return *deque_at(deque, deque->count - 1);
+}
+
+static queue_t* queue_argument(value_t value, char* error_string, int line) {
+    if (!IS_QUEUE(value)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    return AS_QUEUE(value);
+}
+
+static value_t builtin_priority_queue(value_t* args, int line) {
+    return QUEUE_VALUE(queue_init());
+}
+
+static value_t builtin_push(value_t* args, int line) {
+    queue_t* queue = queue_argument(args[0], "Expected a priority queue in push()", line);
+
+    if (!IS_NUMBER(args[1]) || AS_NUMBER(args[1]) != AS_NUMBER(args[1])) {
+        error_throw(ERROR_RUNTIME, "Expected the priority in push() to be a number", line);
+    }
+
+    queue_push(queue, AS_NUMBER(args[1]), args[2]);
+    return args[0];
+}
+
+static value_t builtin_pop(value_t* args, int line) {
+    queue_t* queue = queue_argument(args[0], "Expected a priority queue in pop()", line);
+
+    if (queue->count == 0) {
+        error_throw(ERROR_RUNTIME, "Expected a non-empty priority queue in pop()", line);
+    }
+
+    return queue_pop(queue);
+}
+
+static value_t builtin_peek(value_t* args, int line) {
+    queue_t* queue = queue_argument(args[0], "Expected a priority queue in peek()", line);
+
+    if (queue->count == 0) {
+        error_throw(ERROR_RUNTIME, "Expected a non-empty priority queue in peek()", line);
+    }
+
+    return queue->values[0];
+}
+
+static value_t builtin_peek_priority(value_t* args, int line) {
+    queue_t* queue = queue_argument(args[0], "Expected a priority queue in peek_priority()", line);
+
+    if (queue->count == 0) {
+        error_throw(ERROR_RUNTIME, "Expected a non-empty priority queue in peek_priority()", line);
+    }
+
+    return NUMBER_VALUE(queue->priorities[0]);
+}
+
+static bitset_t* bitset_argument(value_t value, char* error_string, int line) {
+    if (!IS_BITSET(value)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    return AS_BITSET(value);
+}
+
+static int bit_argument(bitset_t* bitset, value_t value, int line) {
+    if (!IS_NUMBER(value) || AS_NUMBER(value) < 0 || AS_NUMBER(value) >= bitset->size) {
+        error_throw(ERROR_RUNTIME, "Bit index out of range", line);
+    }
+
+    return (int)AS_NUMBER(value);
+}
+
+static value_t builtin_bitset(value_t* args, int line) {
+    if (!IS_NUMBER(args[0]) || AS_NUMBER(args[0]) < 0) {
+        error_throw(ERROR_RUNTIME, "Expected the size in bitset() to be a non-negative number", line);
+    }
+
+    return BITSET_VALUE(bitset_init((int)AS_NUMBER(args[0])));
+}
+
+static value_t builtin_set_bit(value_t* args, int line) {
+    bitset_t* bitset = bitset_argument(args[0], "Expected a bitset in set_bit()", line);
+    bitset_set(bitset, bit_argument(bitset, args[1], line));
+
+    return args[0];
+}
+
+static value_t builtin_clear_bit(value_t* args, int line) {
+    bitset_t* bitset = bitset_argument(args[0], "Expected a bitset in clear_bit()", line);
+    bitset_clear(bitset, bit_argument(bitset, args[1], line));
+
+    return args[0];
+}
+
+static value_t builtin_test_bit(value_t* args, int line) {
+    bitset_t* bitset = bitset_argument(args[0], "Expected a bitset in test_bit()", line);
+    return BOOLEAN_VALUE(bitset_test(bitset, bit_argument(bitset, args[1], line)));
+}
+
+static value_t builtin_popcount(value_t* args, int line) {
+    bitset_t* bitset = bitset_argument(args[0], "Expected a bitset in popcount()", line);
+    return NUMBER_VALUE((number_t)bitset_count(bitset));
+}
+
+static value_t builtin_union(value_t* args, int line) {
+    bitset_t* left = bitset_argument(args[0], "Expected bitsets in union()", line);
+    bitset_t* right = bitset_argument(args[1], "Expected bitsets in union()", line);
+
+    return BITSET_VALUE(bitset_union(left, right));
+}
+
+static value_t builtin_intersection(value_t* args, int line) {
+    bitset_t* left = bitset_argument(args[0], "Expected bitsets in intersection()", line);
+    bitset_t* right = bitset_argument(args[1], "Expected bitsets in intersection()", line);
+
+    return BITSET_VALUE(bitset_intersection(left, right));
+}
+
+void builtins_register() {
+    natives_register("sum", 1, builtin_sum);
+    natives_register("min", 1, builtin_min);
+    natives_register("max", 1, builtin_max);
+    natives_register("dot", 2, builtin_dot);
+    natives_register("scale", 2, builtin_scale);
+    natives_register("fill", 2, builtin_fill);
+    natives_register("keys", 1, builtin_keys);
+    natives_register("values", 1, builtin_values);
+    natives_register("has", 2, builtin_has);
+    natives_register("tree", 0, builtin_tree);
+    natives_register("insert", 3, builtin_insert);
+    natives_register("lookup", 2, builtin_lookup);
+    natives_register("floor_key", 3, builtin_floor_key);
+    natives_register("ceiling_key", 3, builtin_ceiling_key);
+    natives_register("range_keys", 3, builtin_range_keys);
+    natives_register("range_values", 3, builtin_range_values);
+    natives_register("deque", 0, builtin_deque);
+    natives_register("push_back", 2, builtin_push_back);
+    natives_register("push_front", 2, builtin_push_front);
+    natives_register("pop_back", 1, builtin_pop_back);
+    natives_register("pop_front", 1, builtin_pop_front);
+    natives_register("front", 1, builtin_front);
+    natives_register("back", 1, builtin_back);
+    natives_register("priority_queue", 0, builtin_priority_queue);
+    natives_register("push", 3, builtin_push);
+    natives_register("pop", 1, builtin_pop);
+    natives_register("peek", 1, builtin_peek);
+    natives_register("peek_priority", 1, builtin_peek_priority);
+    natives_register("bitset", 1, builtin_bitset);
+    natives_register("set_bit", 2, builtin_set_bit);
+    natives_register("clear_bit", 2, builtin_clear_bit);
+    natives_register("test_bit", 2, builtin_test_bit);
+    natives_register("popcount", 1, builtin_popcount);
+    natives_register("union", 2, builtin_union);
+    natives_register("intersection", 2, builtin_intersection);
+}
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "vm/natives.h"
+#include "vm/builtins.h"
+#include "utils/error.h"
+
+// natives are allocated one by one, so that the values pointing at them survive later registrations
+static native_t** natives = NULL;
+static int native_count = 0;
+static int native_capacity = 0;
+
+static void ensure_builtins() {
+    if (natives == NULL) {
+        native_capacity = NATIVES_INITIAL_SIZE;
+        natives = (native_t**)malloc(native_capacity * sizeof(native_t*));
+
+        if (natives == NULL) {
+            error_throw(ERROR_RUNTIME, "Failed to allocate memory for natives", 0);
+        }
+
+        builtins_register();
+    }
+}
+
+void natives_register(const char* name, int arity, native_function_t function) {
+    ensure_builtins();
+
+    if (arity < 0 || arity > UINT8_MAX) {
+        error_throw(ERROR_RUNTIME, "Invalid arity of a native function", 0);
+    }
+
+    for (int i = 0; i < native_count; i++) {
+        if (strcmp(natives[i]->name, name) == 0) {
+            natives[i]->arity = arity;
+            natives[i]->function = function;
+            return;
+        }
+    }
+
+    if (native_count == UINT16_MAX) {
+        error_throw(ERROR_RUNTIME, "Too many native functions", 0);
+    }
+
+    if (native_count == native_capacity) {
+        native_capacity *= 2;
+        natives = (native_t**)realloc(natives, native_capacity * sizeof(native_t*));
+
+        if (natives == NULL) {
+            error_throw(ERROR_RUNTIME, "Failed to reallocate memory for natives", 0);
+        }
+    }
+
+    native_t* native = (native_t*)malloc(sizeof(native_t));
+
+    if (native == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for a native", 0);
+    }
+
+    native->name = strdup(name);
+    native->arity = arity;
+    native->function = function;
+
+    natives[native_count++] = native;
+}
+
+int natives_count() {
+    ensure_builtins();
+    return native_count;
+}
+
+native_t* natives_get(int index) {
+    ensure_builtins();
+    return index >= 0 && index < native_count ? natives[index] : NULL;
+}
+
+void natives_install(value_t* globals, int count) {
+    for (int i = 0; i < count; i++) {
+        globals[i] = NATIVE_VALUE(natives_get(i));
+    }
+}
@@ -0,0 +1,778 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "vm/operations.h"
+#include "utils/common.h"
+#include "utils/error.h"
+#include "utils/memory.h"
+#include "utils/shape.h"
+#include "utils/tree.h"
+#include "utils/deque.h"
+#include "utils/queue.h"
+#include "utils/bitset.h"
+
+#define TYPE_CHECKING
+
+static inline value_t number(double number) {
+    return NUMBER_VALUE(number);
+}
+
+static inline value_t boolean(bool boolean) {
+    return BOOLEAN_VALUE(boolean);
+}
+
+static inline value_t string(char* string) {
+    return STRING_VALUE(string);
+}
+
+static inline void check_numbers(value_t left, value_t right, char* error_string, int line) {
+    #ifdef TYPE_CHECKING
+    if (!IS_NUMBER(left) || !IS_NUMBER(right)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+    #endif
+}
+
+// COPY ON WRITE
+
+static inline bool is_shared(value_t value) {
+    return (IS_ARRAY(value) && AS_ARRAY(value)->refcount > 1) || (IS_MAP(value) && AS_MAP(value)->refcount > 1);
+}
+
+static inline value_t copy(value_t value) {
+    return IS_MAP(value) ? MAP_VALUE(map_copy(AS_MAP(value))) : ARRAY_VALUE(array_copy(AS_ARRAY(value)));
+}
+
+value_t operation_separate(value_t value) {
+    return is_shared(value) ? copy(value) : value;
+}
+
+static inline bool is_same(value_t value, value_t container) {
+    return (IS_ARRAY(value) && IS_ARRAY(container) && AS_ARRAY(value) == AS_ARRAY(container))
+        || (IS_MAP(value) && IS_MAP(container) && AS_MAP(value) == AS_MAP(container));
+}
+
+// whether a value is the container or holds it in one of its nested elements
+static bool holds(value_t value, value_t container) {
+    if (is_same(value, container)) {
+        return true;
+    }
+
+    if (IS_ARRAY(value) && AS_ARRAY(value)->kind == ARRAY_VALUES) {
+        array_t* array = AS_ARRAY(value);
+
+        for (int i = 0; i < array->size; i++) {
+            if (holds(array->elements.values[i], container)) {
+                return true;
+            }
+        }
+    }
+
+    if (IS_MAP(value)) {
+        map_t* map = AS_MAP(value);
+
+        for (int i = 0; i < map->count; i++) {
+            if (holds(map->entries[i].value, container)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Storing a value holding the container into the container would make it hold itself, so the value
+// is replaced by a copy in which the container is a snapshot from before the store. Only maps and
+// arrays of values are searched, as numbers, strings and packed arrays cannot hold the container.
+static value_t detach(value_t value, value_t container) {
+    if (is_same(value, container)) {
+        return copy(value);
+    }
+
+    if (!holds(value, container)) {
+        return value;
+    }
+
+    value_t result = copy(value);
+
+    if (IS_MAP(result)) {
+        map_t* map = AS_MAP(result);
+
+        for (int i = 0; i < map->count; i++) {
+            map_entry_t entry = map->entries[i];
+
+            if (holds(entry.value, container)) {
+                map_set(map, entry.key, detach(entry.value, container));
+            }
+        }
+
+        return result;
+    }
+
+    array_t* array = AS_ARRAY(result);
+
+    for (int i = 0; i < array->size; i++) {
+        value_t element = array->elements.values[i];
+
+        if (holds(element, container)) {
+            array_set_element(array, i, detach(element, container));
+        }
+    }
+
+    return result;
+}
+
+// ARITHMETIC
+
+// an array with more owners than the ones the result replaces is copied before being mutated
+static inline array_t* writable_array(value_t value, int owners) {
+    array_t* array = AS_ARRAY(value);
+    return array->refcount > owners ? array_copy(array) : array;
+}
+
+static value_t add(value_t left, value_t right, int owners, int line) {
+    if (IS_ARRAY(left)) {
+        array_t* array = writable_array(left, owners);
+
+        if (array->kind == ARRAY_NUMBERS && IS_NUMBER(right) && array->size < array->capacity) {
+            array->elements.numbers[array->size++] = AS_NUMBER(right);
+        } else {
+            array_append(array, detach(right, ARRAY_VALUE(array)));
+        }
+
+        return ARRAY_VALUE(array);
+    }
+
+    if (IS_NUMBER(left) && IS_NUMBER(right)) {
+        return number(AS_NUMBER(left) + AS_NUMBER(right));
+    }
+
+    if (IS_STRING(left) && IS_STRING(right)) {
+        return string(string_concat(AS_STRING(left), AS_STRING(right)));
+    }
+
+    error_throw(ERROR_RUNTIME, "Unknown operands to OP_ADD", line);
+    return number(0);
+}
+
+value_t operation_add(value_t left, value_t right, int line) {
+    return add(left, right, 0, line);
+}
+
+value_t operation_add_assign(value_t left, value_t right, int line) {
+    return add(left, right, 1, line);
+}
+
+static value_t sub(value_t left, value_t right, int owners, int line) {
+    if (IS_ARRAY(left) && IS_NUMBER(right)) {
+        array_t* array = writable_array(left, owners);
+        array_remove(array, (int)AS_NUMBER(right));
+        return ARRAY_VALUE(array);
+    }
+
+    if (IS_MAP(left) && map_is_key(right)) {
+        map_t* map = AS_MAP(left);
+
+        if (map_get(map, right) == NULL) {
+            return left;
+        }
+
+        map = map->refcount > owners ? map_copy(map) : map;
+        map_delete(map, right);
+        return MAP_VALUE(map);
+    }
+
+    if (IS_NUMBER(left) && IS_NUMBER(right)) {
+        return number(AS_NUMBER(left) - AS_NUMBER(right));
+    }
+
+    error_throw(ERROR_RUNTIME, "Unknown operands to OP_SUB", line);
+    return number(0);
+}
+
+value_t operation_sub(value_t left, value_t right, int line) {
+    return sub(left, right, 0, line);
+}
+
+value_t operation_sub_assign(value_t left, value_t right, int line) {
+    return sub(left, right, 1, line);
+}
+
+value_t operation_div(value_t left, value_t right, int line) {
+    check_numbers(left, right, "Expected operands of OP_DIV to be numbers", line);
+
+    if (AS_NUMBER(right) == 0) {
+        error_throw(ERROR_RUNTIME, "Division by zero", line);
+    }
+
+    return number(AS_NUMBER(left) / AS_NUMBER(right));
+}
+
+value_t operation_div_floor(value_t left, value_t right, int line) {
+    check_numbers(left, right, "Expected operands of OP_DIV_FLOOR to be numbers", line);
+
+    if (AS_NUMBER(right) == 0) {
+        error_throw(ERROR_RUNTIME, "Division by zero", line);
+    }
+
+    return number(floor(AS_NUMBER(left) / AS_NUMBER(right)));
+}
+
+value_t operation_neg(value_t value, int line) {
+    switch (value_get_type(value)) {
+        case TYPE_NUMBER: {
+            return number(-AS_NUMBER(value));
+        }
+        case TYPE_BOOLEAN: {
+            return boolean(!AS_BOOLEAN(value));
+        }
+        default: {
+            error_throw(ERROR_RUNTIME, "Invalid datatype in negation", line);
+            return number(0);
+        }
+    }
+}
+
+// COMPARISON
+
+static bool values_equal(value_t left, value_t right, char* error_string, int line) {
+    if (value_get_type(left) != value_get_type(right)) {
+        error_throw(ERROR_RUNTIME, error_string, line);
+    }
+
+    switch (value_get_type(left)) {
+        case TYPE_NUMBER: {
+            return AS_NUMBER(left) == AS_NUMBER(right);
+        }
+        case TYPE_BOOLEAN: {
+            return AS_BOOLEAN(left) == AS_BOOLEAN(right);
+        }
+        case TYPE_STRING: {
+            char* left_string = AS_STRING(left);
+            char* right_string = AS_STRING(right);
+
+            // distinct interned strings never have equal contents
+            if (left_string == right_string) {
+                return true;
+            }
+
+            if (memory_is_interned(left_string) && memory_is_interned(right_string)) {
+                return false;
+            }
+
+            size_t length = string_length(left_string);
+
+            // ropes know their length, so only strings of equal lengths are flattened
+            if (length != string_length(right_string)) {
+                return false;
+            }
+
+            // hashes are only compared when both are already cached, so comparing never hashes a string
+            string_header_t* left_header = string_header(left_string);
+            string_header_t* right_header = string_header(right_string);
+
+            if ((left_header->flags & right_header->flags & STRING_HASHED) && left_header->hash != right_header->hash) {
+                return false;
+            }
+
+            return memcmp(string_chars(left_string), string_chars(right_string), length) == 0;
+        }
+        default: {
+            error_throw(ERROR_RUNTIME, "Unknown datatype for comparison", line);
+            return false;
+        }
+    }
+}
+
+value_t operation_cmp_eq(value_t left, value_t right, int line) {
+    return boolean(values_equal(left, right, "Cannot cmp_eq two values of different datatypes", line));
+}
+
+value_t operation_cmp_ne(value_t left, value_t right, int line) {
+    return boolean(!values_equal(left, right, "Cannot cmp_ne two values of different datatypes", line));
+}
+
+// ARRAYS
+
+value_t operation_array_def(value_t* elements, int count) {
+    array_kind kind = count > 0 ? array_kind_of(elements[0]) : ARRAY_NUMBERS;
+
+    for (int i = 1; i < count && kind != ARRAY_VALUES; i++) {
+        if (array_kind_of(elements[i]) != kind) {
+            kind = ARRAY_VALUES;
+        }
+    }
+
+    array_t* array = array_init(count, kind);
+
+    for (int i = 0; i < count; i++) {
+        array_add_element(array, i, elements[i]);
+        value_retain(elements[i]);
+    }
+
+    return ARRAY_VALUE(array);
+}
+
+// MAPS
+
+static inline void check_key(value_t key, int line) {
+    if (!map_is_key(key)) {
+        error_throw(ERROR_RUNTIME, "Expected map keys to be numbers, booleans or strings", line);
+    }
+}
+
+value_t operation_map_def(value_t* elements, int count, int line) {
+    map_t* map = map_init(count);
+
+    for (int i = 0; i < count; i++) {
+        check_key(elements[2 * i], line);
+        map_set(map, elements[2 * i], elements[2 * i + 1]);
+    }
+
+    return MAP_VALUE(map);
+}
+
+value_t operation_array_get(value_t array_value, value_t index_value, int line) {
+    if (IS_MAP(array_value)) {
+        check_key(index_value, line);
+        value_t* value = map_get(AS_MAP(array_value), index_value);
+
+        if (value == NULL) {
+            error_throw(ERROR_RUNTIME, "Key not found in map", line);
+        }
+
+        return *value;
+    }
+
+    #ifdef TYPE_CHECKING
+    if (!IS_NUMBER(index_value)) {
+        error_throw(ERROR_RUNTIME, "Expected index to be a number", line);
+    }
+    #endif
+
+    int index = (int)AS_NUMBER(index_value);
+
+    if (IS_ARRAY(array_value)) {
+        array_t* array = AS_ARRAY(array_value);
+
+        if (index >= array->size) {
+            error_throw(ERROR_RUNTIME, "Index out of range", line);
+        }
+
+        if (array->kind == ARRAY_NUMBERS) {
+            return number(array->elements.numbers[index]);
+        }
+
+        return array_get_element(array, index);
+    }
+
+    if (IS_STRING(array_value)) {
+        string_t string_value = AS_STRING(array_value);
+
+        if (index >= string_length(string_value)) {
+            error_throw(ERROR_RUNTIME, "Index out of range", line);
+        }
+
+        return string(memory_character_string(string_chars(string_value)[index]));
+    }
+
+    error_throw(ERROR_RUNTIME, "Unsupported value type in OP_ARRAY_GET", line);
+    return number(0);
+}
+
+value_t operation_array_get_separate(value_t array_value, value_t index_value, int line) {
+    value_t element = operation_array_get(array_value, index_value, line);
+
+    if (is_shared(element)) {
+        element = copy(element);
+        operation_array_set(array_value, index_value, element, line);
+    }
+
+    return element;
+}
+
+void operation_array_set(value_t array_value, value_t index_value, value_t value, int line) {
+    if (IS_MAP(array_value)) {
+        check_key(index_value, line);
+        map_set(AS_MAP(array_value), index_value, detach(value, array_value));
+        return;
+    }
+
+    #ifdef TYPE_CHECKING
+    if (!IS_ARRAY(array_value)) {
+        error_throw(ERROR_RUNTIME, "Expected an array or a map in OP_ARRAY_SET", line);
+    }
+
+    if (!IS_NUMBER(index_value)) {
+        error_throw(ERROR_RUNTIME, "Expected index to be a number", line);
+    }
+    #endif
+
+    array_t* array = AS_ARRAY(array_value);
+    int index = (int)AS_NUMBER(index_value);
+
+    if (index >= array->size) {
+        error_throw(ERROR_RUNTIME, "Index out of range", line);
+    }
+
+    if (array->kind == ARRAY_NUMBERS && IS_NUMBER(value)) {
+        array->elements.numbers[index] = AS_NUMBER(value);
+        return;
+    }
+
+    array_set_element(array, index, detach(value, array_value));
+}
+
+value_t operation_slice(value_t string_value, value_t start_value, value_t end_value, int line) {
+    #ifdef TYPE_CHECKING
+    if (!IS_NUMBER(start_value) || !IS_NUMBER(end_value)) {
+        error_throw(ERROR_RUNTIME, "Expected slice indices to be numbers", line);
+    }
+    #endif
+
+    if (!IS_STRING(string_value)) {
+        error_throw(ERROR_RUNTIME, "Unsupported value type in OP_SLICE", line);
+    }
+
+    int start = (int)AS_NUMBER(start_value);
+    int end = (int)AS_NUMBER(end_value);
+
+    if (start < 0 || end < start || end > string_length(AS_STRING(string_value))) {
+        error_throw(ERROR_RUNTIME, "Slice out of range", line);
+    }
+
+    return string(string_slice(AS_STRING(string_value), start, end - start));
+}
+
+value_t operation_sizeof(value_t value, int line) {
+    switch (value_get_type(value)) {
+        case TYPE_STRING: {
+            return number((double)string_length(AS_STRING(value)));
+        }
+        case TYPE_ARRAY: {
+            return number((double)AS_ARRAY(value)->size);
+        }
+        case TYPE_MAP: {
+            return number((double)AS_MAP(value)->count);
+        }
+        case TYPE_TREE: {
+            return number((double)AS_TREE(value)->count);
+        }
+        case TYPE_DEQUE: {
+            return number((double)AS_DEQUE(value)->count);
+        }
+        case TYPE_QUEUE: {
+            return number((double)AS_QUEUE(value)->count);
+        }
+        case TYPE_BITSET: {
+            return number((double)AS_BITSET(value)->size);
+        }
+        default: {
+            error_throw(ERROR_RUNTIME, "Unsupported datatype in sizeof", line);
+            return number(0);
+        }
+    }
+}
+
+// OBJECTS
+
+static inline void cache_add(inline_cache_t* cache, shape_t* shape, shape_t* transition, int slot) {
+    if (cache->count < INLINE_CACHE_SIZE) {
+        cache->entries[cache->count++] = (inline_cache_entry_t){ .shape = shape, .transition = transition, .slot = slot };
+    }
+}
+
+value_t operation_load_prop(value_t value, value_t identifier, inline_cache_t* cache, int line) {
+    switch (value_get_type(value)) {
+        case TYPE_OBJECT: {
+            object_t* object = AS_OBJECT(value);
+
+            for (int i = 0; i < cache->count; i++) {
+                if (cache->entries[i].shape == object->shape) {
+                    return object->slots[cache->entries[i].slot];
+                }
+            }
+
+            int slot = shape_lookup(object->shape, AS_STRING(identifier));
+
+            if (slot == -1) {
+                error_throw(ERROR_RUNTIME, "Object property with the given identifier does not exist", line);
+            }
+
+            cache_add(cache, object->shape, object->shape, slot);
+
+            return object->slots[slot];
+        }
+        case TYPE_ENUM: {
+            value_t* item = table_get(AS_ENUM(value)->values, AS_STRING(identifier));
+
+            if (item == NULL) {
+                error_throw(ERROR_RUNTIME, "Enum item with the given identifier does not exist", line);
+            }
+
+            return *item;
+        }
+        default: {
+            error_throw(ERROR_RUNTIME, "Unknown datatype in OP_PROP_LOAD_CONST", line);
+            return number(0);
+        }
+    }
+}
+
+void operation_store_prop(value_t object_value, value_t identifier, value_t value, inline_cache_t* cache, int line) {
+    #ifdef TYPE_CHECKING
+    if (!IS_OBJECT(object_value)) {
+        error_throw(ERROR_RUNTIME, "Expected an object in OP_STORE_PROP", line);
+    }
+    #endif
+
+    object_t* object = AS_OBJECT(object_value);
+    shape_t* shape = object->shape;
+
+    for (int i = 0; i < cache->count; i++) {
+        inline_cache_entry_t* entry = &cache->entries[i];
+
+        if (entry->shape == shape) {
+            // a transition adds the slot, which holds no previous value yet
+            if (entry->transition != shape) {
+                object_transition(object, entry->transition);
+                object->slots[entry->slot] = number(0);
+            }
+
+            value_store(&object->slots[entry->slot], value);
+            memory_write_barrier(object, value);
+            return;
+        }
+    }
+
+    int slot = shape_lookup(shape, AS_STRING(identifier));
+
+    if (slot == -1) {
+        object_transition(object, shape_transition(shape, AS_STRING(identifier)));
+        slot = object->shape->count - 1;
+        object->slots[slot] = number(0);
+    }
+
+    cache_add(cache, shape, object->shape, slot);
+
+    value_store(&object->slots[slot], value);
+    memory_write_barrier(object, value);
+}
+
+value_t operation_load_prop_separate(value_t object, value_t identifier, inline_cache_t* cache, int line) {
+    value_t value = operation_load_prop(object, identifier, cache, line);
+
+    if (is_shared(value)) {
+        value = copy(value);
+        operation_store_prop(object, identifier, value, cache, line);
+    }
+
+    return value;
+}
+
+// PRINTING
+
+static void print_any(value_t* value);
+
+static void print_numeric_literal(value_t* value) {
+    if (AS_NUMBER(*value) == (int)AS_NUMBER(*value)) {
+        printf("%d", (int)AS_NUMBER(*value));
+    } else {
+        printf("%.2f", AS_NUMBER(*value));
+    }
+}
+
+static void print_boolean_literal(value_t* value) {
+    printf("%s", AS_BOOLEAN(*value) ? "true" : "false");
+}
+
+static void print_segment(const char* chars, size_t length, void* context) {
+    fwrite(chars, sizeof(char), length, stdout);
+}
+
+// ropes are printed segment by segment, without being flattened
+static void print_string_literal(value_t* value) {
+    string_for_each_segment(AS_STRING(*value), print_segment, NULL);
+}
+
+static void print_array(value_t* value) {
+    printf("[");
+
+    array_t* array = AS_ARRAY(*value);
+
+    for (int i = 0; i < array->size; i++) {
+        value_t element = array_get_element(array, i);
+
+        if (IS_STRING(element)) printf("\"");
+        print_any(&element);
+        if (IS_STRING(element)) printf("\"");
+
+        if (i < array->size - 1) {
+            printf(", ");
+        }
+    }
+
+    printf("]");
+}
+
+static void print_entry(value_t key, value_t element) {
+    if (IS_STRING(key)) printf("\"");
+    print_any(&key);
+    if (IS_STRING(key)) printf("\"");
+
+    printf(": ");
+
+    if (IS_STRING(element)) printf("\"");
+    print_any(&element);
+    if (IS_STRING(element)) printf("\"");
+}
+
+static void print_map(value_t* value) {
+    printf("{");
+
+    map_t* map = AS_MAP(*value);
+
+    for (int i = 0; i < map->count; i++) {
+        print_entry(map->entries[i].key, map->entries[i].value);
+
+        if (i < map->count - 1) {
+            printf(", ");
+        }
+    }
+
+    printf("}");
+}
+
+static void print_tree_entry(value_t key, value_t element, void* context) {
+    int* remaining = (int*)context;
+    print_entry(key, element);
+
+    if (--*remaining > 0) {
+        printf(", ");
+    }
+}
+
+// ordered maps print like maps, in ascending key order
+static void print_tree(value_t* value) {
+    printf("{");
+
+    tree_t* tree = AS_TREE(*value);
+    int remaining = tree->count;
+    tree_for_each(tree, print_tree_entry, &remaining);
+
+    printf("}");
+}
+
+// deques print like arrays, from front to back
+static void print_deque(value_t* value) {
+    printf("[");
+
+    deque_t* deque = AS_DEQUE(*value);
+
+    for (int i = 0; i < deque->count; i++) {
+        value_t element = *deque_at(deque, i);
+
+        if (IS_STRING(element)) printf("\"");
+        print_any(&element);
+        if (IS_STRING(element)) printf("\"");
+
+        if (i < deque->count - 1) {
+            printf(", ");
+        }
+    }
+
+    printf("]");
+}
+
+// priority queues print their priorities and values in heap order, the lowest priority first
+static void print_queue(value_t* value) {
+    printf("{");
+
+    queue_t* queue = AS_QUEUE(*value);
+
+    for (int i = 0; i < queue->count; i++) {
+        print_entry(NUMBER_VALUE(queue->priorities[i]), queue->values[i]);
+
+        if (i < queue->count - 1) {
+            printf(", ");
+        }
+    }
+
+    printf("}");
+}
+
+// bitsets print the indices of their set bits
+static void print_bitset(value_t* value) {
+    printf("{");
+
+    bitset_t* bitset = AS_BITSET(*value);
+    bool first = true;
+
+    for (int i = 0; i < bitset->size; i++) {
+        if (bitset_test(bitset, i)) {
+            printf(first ? "%d" : ", %d", i);
+            first = false;
+        }
+    }
+
+    printf("}");
+}
+
+static void print_object(value_t* value) {
+    printf("[object]: not implemented");
+}
+
+static void print_enum(value_t* value) {
+    printf("[enum]: not implemented");
+}
+
+static void print_native(value_t* value) {
+    printf("[native]: %s", AS_NATIVE(*value)->name);
+}
+
+static void print_any(value_t* value) {
+    switch (value_get_type(*value)) {
+        case TYPE_NUMBER: {
+            return print_numeric_literal(value);
+        }
+        case TYPE_BOOLEAN: {
+            return print_boolean_literal(value);
+        }
+        case TYPE_STRING: {
+            return print_string_literal(value);
+        }
+        case TYPE_ARRAY: {
+            return print_array(value);
+        }
+        case TYPE_OBJECT: {
+            return print_object(value);
+        }
+        case TYPE_ENUM: {
+            return print_enum(value);
+        }
+        case TYPE_NATIVE: {
+            return print_native(value);
+        }
+        case TYPE_MAP: {
+            return print_map(value);
+        }
+        case TYPE_TREE: {
+            return print_tree(value);
+        }
+        case TYPE_DEQUE: {
+            return print_deque(value);
+        }
+        case TYPE_QUEUE: {
+            return print_queue(value);
+        }
+        case TYPE_BITSET: {
+            return print_bitset(value);
+        }
+    }
+}
+
+void operation_print(value_t value) {
+    print_any(&value);
+}
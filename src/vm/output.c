@@ -7,6 +7,53 @@
 #include "utils/error.h"
 #include "utils/common.h"
 
+// values are copied outside of the managed heap, so that neither later mutations
+// nor garbage collections change the recorded output
+static value_t copy_value(value_t value) {
+    switch (value_get_type(value)) {
+        case TYPE_STRING: {
+            return STRING_VALUE(strdup(string_flatten(AS_STRING(value))));
+        }
+        case TYPE_ARRAY: {
+            array_t* array = AS_ARRAY(value);
+            array_t* copied_array = (array_t*)malloc(sizeof(array_t));
+            copied_array->size = array->size;
+            copied_array->capacity = array->size;
+            copied_array->refcount = 0;
+            copied_array->kind = ARRAY_VALUES;
+            copied_array->elements.values = (value_t*)malloc(array->size * sizeof(value_t));
+
+            for (int i = 0; i < array->size; i++) {
+                copied_array->elements.values[i] = copy_value(array_get_element(array, i));
+            }
+
+            return ARRAY_VALUE(copied_array);
+        }
+        case TYPE_MAP: {
+            map_t* map = AS_MAP(value);
+            map_t* copied_map = (map_t*)malloc(sizeof(map_t));
+            copied_map->count = map->count;
+            copied_map->capacity = map->capacity;
+            copied_map->refcount = 0;
+            copied_map->entries = (map_entry_t*)malloc(map->capacity * sizeof(map_entry_t));
+            copied_map->buckets = (int*)malloc(map->capacity * 2 * sizeof(int));
+
+            for (int i = 0; i < map->count; i++) {
+                copied_map->entries[i].key = copy_value(map->entries[i].key);
+                copied_map->entries[i].value = copy_value(map->entries[i].value);
+                copied_map->entries[i].hash = map->entries[i].hash;
+            }
+
+            memcpy(copied_map->buckets, map->buckets, map->capacity * 2 * sizeof(int));
+
+            return MAP_VALUE(copied_map);
+        }
+        default: {
+            return value;
+        }
+    }
+}
+
 output_t* output_init() {
     output_t* output = (output_t*)malloc(sizeof(output_t));
 
@@ -37,31 +84,7 @@ void output_add(output_t* output, value_t value) {
         }
     }
 
-    value_t copied_value = value;
-
-    switch (value.type) {
-        case TYPE_STRING: {
-            copied_value.type = TYPE_STRING;
-            copied_value.as.string = strdup(value.as.string);
-            break;
-        }
-        case TYPE_ARRAY: {
-            copied_value.type = TYPE_ARRAY;
-            copied_value.as.array = *array_init(value.as.array.size);
-
-            for (int i = 0; i < value.as.array.size; i++) {
-                array_add_element(&copied_value.as.array, i, value.as.array.elements[i]);
-            }
-
-            break;
-        }
-        default: {
-            copied_value = value;
-            break;
-        }
-    }
-
-    output->values[output->count] = copied_value;
+    output->values[output->count] = copy_value(value);
     output->count++;
 }
 
@@ -1,16 +1,26 @@
 #include "vm/pool.h"
 
-// TODO: do string interning -> store the same values only once and retrieve the correct index at pool_get()
-
 pool_t* pool_init(uint16_t initial_capacity) {
     pool_t* pool = (pool_t*)malloc(sizeof(pool_t));
     pool->count = 0;
     pool->capacity = initial_capacity;
     pool->values = (value_t *)malloc(sizeof(value_t) * pool->capacity);
+    pool->strings = table_init(initial_capacity);
     return pool;
 }
 
 uint16_t pool_add(pool_t* pool, value_t value) {
+    // strings are interned, so equal string constants are stored only once
+    if (IS_STRING(value)) {
+        value_t* index = table_get(pool->strings, AS_STRING(value));
+
+        if (index != NULL) {
+            return (uint16_t)AS_NUMBER(*index);
+        }
+
+        table_set(pool->strings, AS_STRING(value), NUMBER_VALUE(pool->count));
+    }
+
     if (pool->count == pool->capacity) {
         pool->capacity *= 2;
         pool->values = (value_t *)realloc(pool->values, sizeof(value_t) * pool->capacity);
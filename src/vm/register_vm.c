@@ -0,0 +1,1240 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler/bytecode.h"
+#include "compiler/compiler.h"
+#include "compiler/instruction.h"
+#include "utils/common.h"
+#include "utils/error.h"
+#include "utils/memory.h"
+#include "vm/register_vm.h"
+#include "vm/natives.h"
+#include "vm/pool.h"
+#include "vm/output.h"
+#include "vm/operations.h"
+
+//#define DEBUG
+#define TYPE_CHECKING
+
+#define TRANSLATOR_STACK_SIZE 256
+
+static bool is_testing = false;
+
+static register_virtual_machine_t rvm;
+static output_t* output;
+
+output_t* register_vm_get_output() {
+    return output;
+}
+
+static inline value_t number(double number) {
+    return NUMBER_VALUE(number);
+}
+
+static inline value_t boolean(bool boolean) {
+    return BOOLEAN_VALUE(boolean);
+}
+
+// REGISTER CODE
+
+static register_code_t* register_code_init() {
+    register_code_t* code = (register_code_t*)malloc(sizeof(register_code_t));
+
+    if (code == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for register code", 0);
+        return NULL;
+    }
+
+    code->count = 0;
+    code->capacity = REGISTER_CODE_INITIAL_SIZE;
+    code->instructions = (register_instruction_t*)malloc(REGISTER_CODE_INITIAL_SIZE * sizeof(register_instruction_t));
+    code->lines = (int*)malloc(REGISTER_CODE_INITIAL_SIZE * sizeof(int));
+
+    if (code->instructions == NULL || code->lines == NULL) {
+        error_throw(ERROR_RUNTIME, "Failed to allocate memory for register instructions", 0);
+        return NULL;
+    }
+
+    return code;
+}
+
+static int register_code_add(register_code_t* code, register_instruction_t instruction, int line) {
+    if (code->count == code->capacity) {
+        code->capacity *= 2;
+        code->instructions = (register_instruction_t*)realloc(code->instructions, code->capacity * sizeof(register_instruction_t));
+        code->lines = (int*)realloc(code->lines, code->capacity * sizeof(int));
+
+        if (code->instructions == NULL || code->lines == NULL) {
+            error_throw(ERROR_RUNTIME, "Failed to reallocate memory for register instructions", 0);
+            return -1;
+        }
+    }
+
+    code->instructions[code->count] = instruction;
+    code->lines[code->count] = line;
+
+    return code->count++;
+}
+
+static void register_code_free(register_code_t* code) {
+    if (code != NULL) {
+        free(code->instructions);
+        free(code->lines);
+        free(code);
+    }
+}
+
+// TRANSLATOR
+//
+// The stack bytecode is translated by symbolic execution: instead of pushing values,
+// each instruction pushes the operand (register or constant) that holds its result
+// onto a virtual stack. Locals and constants are therefore read in place, and the
+// virtual stack is only materialized into temporary registers (the slots above the
+// frame's locals) where the stack layout becomes observable: at jumps and jump
+// targets, and for call arguments and array elements, which must be contiguous.
+
+typedef struct {
+    int start;
+    int end;
+    int function;
+    bool is_object;
+} translation_unit_t;
+
+typedef struct {
+    int code_index;
+    int target_ip;
+} jump_fixup_t;
+
+static struct {
+    bytecode_t* bytecode;
+    int ip;
+    int line;
+
+    bool* jump_targets;
+    int* code_by_ip;
+
+    jump_fixup_t* fixups;
+    int fixup_count;
+    int fixup_capacity;
+
+    translation_unit_t* units;
+    int unit_count;
+    int unit_capacity;
+
+    int local_count;
+    int stack[TRANSLATOR_STACK_SIZE];
+    int depth;
+    int max_depth;
+
+    // index of the last emitted instruction whose destination register may be retargeted (-1 if none)
+    int last_result;
+} translator;
+
+static inline int constant_operand(int index) {
+    return -index - 1;
+}
+
+static inline int temp(int depth) {
+    return translator.local_count + depth;
+}
+
+static inline register_instruction_t* last_instruction() {
+    return &rvm.code->instructions[rvm.code->count - 1];
+}
+
+static int emit(byte_t op, int a, int b, int c) {
+    translator.last_result = -1;
+    return register_code_add(rvm.code, (register_instruction_t){ .op = op, .a = a, .b = b, .c = c }, translator.line);
+}
+
+static int emit_result(byte_t op, int a, int b, int c) {
+    int index = emit(op, a, b, c);
+    translator.last_result = index;
+    return index;
+}
+
+static void emit_jump(byte_t op, int target_ip, int b, int c) {
+    int index = emit(op, 0, b, c);
+
+    if (translator.fixup_count == translator.fixup_capacity) {
+        translator.fixup_capacity = translator.fixup_capacity == 0 ? 64 : translator.fixup_capacity * 2;
+        translator.fixups = (jump_fixup_t*)realloc(translator.fixups, translator.fixup_capacity * sizeof(jump_fixup_t));
+    }
+
+    translator.fixups[translator.fixup_count++] = (jump_fixup_t){ .code_index = index, .target_ip = target_ip };
+}
+
+static void push_unit(translation_unit_t unit) {
+    if (translator.unit_count == translator.unit_capacity) {
+        translator.unit_capacity = translator.unit_capacity == 0 ? 16 : translator.unit_capacity * 2;
+        translator.units = (translation_unit_t*)realloc(translator.units, translator.unit_capacity * sizeof(translation_unit_t));
+    }
+
+    translator.units[translator.unit_count++] = unit;
+}
+
+static int add_function(int param_count, int local_count) {
+    if (rvm.function_count == rvm.function_capacity) {
+        rvm.function_capacity = rvm.function_capacity == 0 ? 16 : rvm.function_capacity * 2;
+        rvm.functions = (register_function_t*)realloc(rvm.functions, rvm.function_capacity * sizeof(register_function_t));
+    }
+
+    rvm.functions[rvm.function_count] = (register_function_t){
+        .entry = 0,
+        .param_count = param_count,
+        .local_count = local_count,
+        .frame_size = local_count,
+    };
+
+    return rvm.function_count++;
+}
+
+static void stack_push_operand(int operand) {
+    if (translator.depth == TRANSLATOR_STACK_SIZE) {
+        error_throw(ERROR_RUNTIME, "Expression is too deep to translate to registers", translator.line);
+        return;
+    }
+
+    translator.stack[translator.depth++] = operand;
+
+    if (translator.depth > translator.max_depth) {
+        translator.max_depth = translator.depth;
+    }
+}
+
+static int stack_pop_operand() {
+    if (translator.depth == 0) {
+        error_throw(ERROR_RUNTIME, "Cannot translate bytecode with an unbalanced stack", translator.line);
+        return 0;
+    }
+
+    return translator.stack[--translator.depth];
+}
+
+static void materialize(int from) {
+    for (int i = from; i < translator.depth; i++) {
+        if (translator.stack[i] != temp(i)) {
+            emit(REG_MOVE, temp(i), translator.stack[i], 0);
+            translator.stack[i] = temp(i);
+        }
+    }
+}
+
+// stores into locals are counted by the array they store, so only instructions that never produce arrays,
+// and assigning instructions replacing the value they read from the local, may write into it directly
+static bool can_retarget(register_instruction_t* instruction, int slot) {
+    switch (instruction->op) {
+        case REG_SEPARATE:
+        case REG_ADD_ASSIGN:
+        case REG_SUB_ASSIGN:
+            return instruction->b == slot;
+        case REG_LOAD_GLOBAL:
+        case REG_LOAD_PROP:
+        case REG_LOAD_PROP_SEPARATE:
+        case REG_ARRAY_GET:
+        case REG_ARRAY_GET_SEPARATE:
+        case REG_ADD:
+        case REG_SUB:
+            return false;
+        default:
+            return true;
+    }
+}
+
+static void translate_store_local(int slot) {
+    int value = stack_pop_operand();
+    bool pending_read = false;
+
+    // entries still on the stack that read the old value of the local must be copied out first
+    for (int i = 0; i < translator.depth; i++) {
+        if (translator.stack[i] == slot) {
+            emit(REG_MOVE, temp(i), slot, 0);
+            translator.stack[i] = temp(i);
+            pending_read = true;
+        }
+    }
+
+    if (!pending_read && value == temp(translator.depth) && translator.last_result == rvm.code->count - 1 && last_instruction()->a == value && can_retarget(last_instruction(), slot)) {
+        last_instruction()->a = slot;
+        translator.last_result = -1;
+        return;
+    }
+
+    emit(REG_STORE_LOCAL, slot, value, 0);
+}
+
+static void translate_binary(byte_t op) {
+    int right = stack_pop_operand();
+    int left = stack_pop_operand();
+    int destination = temp(translator.depth);
+
+    emit_result(op, destination, left, right);
+    stack_push_operand(destination);
+}
+
+// property names are always string literals, so the cache of the access site can hold their constant index
+static int translate_property(int identifier, int cache) {
+    if (identifier >= 0) {
+        error_throw(ERROR_RUNTIME, "Cannot translate a property access with a computed identifier", translator.line);
+    }
+
+    rvm.cache_identifiers[cache] = -identifier - 1;
+    return cache;
+}
+
+static void translate_unary(byte_t op) {
+    int value = stack_pop_operand();
+    int destination = temp(translator.depth);
+
+    emit_result(op, destination, value, 0);
+    stack_push_operand(destination);
+}
+
+// the destination of an assigning instruction never equals its left operand until it is retargeted to a local
+static void translate_assign(byte_t op, bool binary) {
+    int right = binary ? stack_pop_operand() : 0;
+    int left = stack_pop_operand();
+    int destination = temp(translator.depth);
+
+    if (destination == left) {
+        destination = temp(translator.depth + 1);
+
+        if (translator.depth + 2 > translator.max_depth) {
+            translator.max_depth = translator.depth + 2;
+        }
+    }
+
+    emit_result(op, destination, left, right);
+    stack_push_operand(destination);
+}
+
+static byte_t fused_jump(byte_t op) {
+    switch (op) {
+        case REG_CMP_EQ: return REG_JUMP_IF_NOT_EQ;
+        case REG_CMP_NE: return REG_JUMP_IF_NOT_NE;
+        case REG_CMP_LT: return REG_JUMP_IF_NOT_LT;
+        case REG_CMP_LE: return REG_JUMP_IF_NOT_LE;
+        case REG_CMP_GT: return REG_JUMP_IF_NOT_GT;
+        case REG_CMP_GE: return REG_JUMP_IF_NOT_GE;
+        default: return REG_NUM_INSTRUCTIONS;
+    }
+}
+
+static void translate_jump_if_false(int target_ip) {
+    int condition = stack_pop_operand();
+    materialize(0);
+
+    if (translator.last_result == rvm.code->count - 1 && last_instruction()->a == condition && condition == temp(translator.depth)) {
+        register_instruction_t* compare = last_instruction();
+        byte_t op = fused_jump(compare->op);
+
+        if (op != REG_NUM_INSTRUCTIONS) {
+            int left = compare->b;
+            int right = compare->c;
+
+            rvm.code->count--;
+            emit_jump(op, target_ip, left, right);
+            return;
+        }
+    }
+
+    emit_jump(REG_JUMP_IF_FALSE, target_ip, condition, 0);
+}
+
+static inline uint16_t read_uint16(int ip) {
+    return bytes_to_uint16(&translator.bytecode->instructions[ip]);
+}
+
+static inline uint32_t read_uint32(int ip) {
+    return bytes_to_uint32(&translator.bytecode->instructions[ip]);
+}
+
+static void translate_enum_def(int global_index) {
+    int ip = translator.ip;
+    int count = 0;
+
+    while (translator.bytecode->instructions[ip] != OP_ENUM_END) {
+        if (translator.bytecode->instructions[ip] != OP_LOAD_CONST || translator.bytecode->instructions[ip + 3] != OP_STORE_ENUM) {
+            error_throw(ERROR_RUNTIME, "OP_STORE_ENUM must follow a OP_LOAD_CONST in enum declaration", translator.line);
+            return;
+        }
+
+        ip += 4;
+        count++;
+    }
+
+    if (count == 0) {
+        error_throw(ERROR_RUNTIME, "Cannot declare an empty enum", translator.line);
+        return;
+    }
+
+    emit(REG_ENUM_DEF, global_index, count, 0);
+
+    for (ip = translator.ip; translator.bytecode->instructions[ip] != OP_ENUM_END; ip += 4) {
+        emit(REG_ENUM_ITEM, read_uint16(ip + 1), 0, 0);
+    }
+
+    translator.ip = ip + 1;
+}
+
+static void translate_instruction(byte_t instruction) {
+    switch (instruction) {
+        case OP_LOAD_CONST: stack_push_operand(constant_operand(read_uint16(translator.ip))); break;
+        case OP_LOAD_LOCAL: stack_push_operand(read_uint16(translator.ip)); break;
+        case OP_STORE_LOCAL: translate_store_local(read_uint16(translator.ip)); break;
+
+        case OP_LOAD_GLOBAL: {
+            int destination = temp(translator.depth);
+            emit_result(REG_LOAD_GLOBAL, destination, read_uint16(translator.ip), 0);
+            stack_push_operand(destination);
+            break;
+        }
+        case OP_STORE_GLOBAL: emit(REG_STORE_GLOBAL, read_uint16(translator.ip), stack_pop_operand(), 0); break;
+
+        case OP_FUNC_DEF: {
+            int global_index = read_uint16(translator.ip);
+            int end = read_uint32(translator.ip + 2);
+            int param_count = translator.bytecode->instructions[translator.ip + 6];
+            int local_count = read_uint16(translator.ip + 7);
+            int body = translator.ip + instruction_operand_size(OP_FUNC_DEF);
+
+            int function = add_function(param_count, local_count);
+            rvm.function_by_ip[body] = function;
+            push_unit((translation_unit_t){ .start = body, .end = end, .function = function, .is_object = false });
+
+            emit(REG_FUNC_DEF, global_index, body, 0);
+            translator.ip = end;
+            return;
+        }
+        case OP_FUNC_END: break;
+        case OP_RETURN: emit(REG_RETURN, stack_pop_operand(), 0, 0); break;
+
+        case OP_CALL: {
+            int arg_count = translator.bytecode->instructions[translator.ip];
+            int base = translator.depth - arg_count - 1;
+
+            materialize(base);
+            emit(REG_CALL, temp(base), arg_count, 0);
+            translator.depth = base;
+            stack_push_operand(temp(base));
+            break;
+        }
+        case OP_CALL_DIRECT: {
+            int global_index = read_uint16(translator.ip);
+            int arg_count = translator.bytecode->instructions[translator.ip + 2];
+            int base = translator.depth - arg_count;
+
+            materialize(base);
+            emit(REG_CALL_DIRECT, temp(base), arg_count, global_index);
+            translator.depth = base;
+            stack_push_operand(temp(base));
+            break;
+        }
+
+        case OP_ENUM_DEF: {
+            int global_index = read_uint16(translator.ip);
+            translator.ip += 2;
+            translate_enum_def(global_index);
+            return;
+        }
+        case OP_STORE_ENUM:
+        case OP_ENUM_END: break;
+
+        case OP_OBJ_DEF: {
+            int object_index = read_uint16(translator.ip);
+            int end = read_uint32(translator.ip + 2);
+            int body = translator.ip + instruction_operand_size(OP_OBJ_DEF);
+
+            int function = add_function(0, 1);
+            rvm.objects[object_index] = function;
+            push_unit((translation_unit_t){ .start = body, .end = end, .function = function, .is_object = true });
+
+            translator.ip = end;
+            return;
+        }
+        case OP_OBJ_END: emit(REG_OBJ_END, 0, 0, 0); break;
+        case OP_NEW_OBJ: {
+            int destination = temp(translator.depth);
+            int object_index = read_uint16(translator.ip);
+
+            emit(rvm.templates[object_index].shape != NULL ? REG_CLONE_OBJ : REG_NEW_OBJ, destination, object_index, 0);
+            stack_push_operand(destination);
+            break;
+        }
+        case OP_LOAD_PROP:
+        case OP_LOAD_PROP_CONST:
+        case OP_LOAD_PROP_SEPARATE: {
+            int cache = translate_property(stack_pop_operand(), read_uint16(translator.ip));
+            int object = stack_pop_operand();
+            int destination = temp(translator.depth);
+
+            emit_result(instruction == OP_LOAD_PROP_SEPARATE ? REG_LOAD_PROP_SEPARATE : REG_LOAD_PROP, destination, object, cache);
+            stack_push_operand(destination);
+            break;
+        }
+        case OP_STORE_PROP:
+        case OP_INIT_PROP: {
+            int cache = translate_property(stack_pop_operand(), read_uint16(translator.ip));
+            int value = stack_pop_operand();
+            int object = stack_pop_operand();
+
+            emit(REG_STORE_PROP, object, cache, value);
+
+            if (instruction == OP_INIT_PROP) {
+                stack_push_operand(object);
+            }
+            break;
+        }
+
+        case OP_ARRAY_DEF: {
+            int count = read_uint16(translator.ip);
+            int base = translator.depth - count;
+
+            materialize(base);
+            emit(REG_ARRAY_DEF, temp(base), count, 0);
+            translator.depth = base;
+            stack_push_operand(temp(base));
+            break;
+        }
+        case OP_ARRAY_GET: translate_binary(REG_ARRAY_GET); break;
+        case OP_ARRAY_GET_SEPARATE: translate_binary(REG_ARRAY_GET_SEPARATE); break;
+        case OP_SEPARATE: translate_assign(REG_SEPARATE, false); break;
+        case OP_ARRAY_SET: {
+            int value = stack_pop_operand();
+            int index = stack_pop_operand();
+            int array = stack_pop_operand();
+
+            emit(REG_ARRAY_SET, array, index, value);
+            break;
+        }
+        case OP_SLICE: {
+            int base = translator.depth - 3;
+
+            materialize(base);
+            emit(REG_SLICE, temp(base), 0, 0);
+            translator.depth = base;
+            stack_push_operand(temp(base));
+            break;
+        }
+        case OP_MAP_DEF: {
+            int count = read_uint16(translator.ip);
+            int base = translator.depth - 2 * count;
+
+            materialize(base);
+            emit(REG_MAP_DEF, temp(base), count, 0);
+            translator.depth = base;
+            stack_push_operand(temp(base));
+            break;
+        }
+        case OP_SIZEOF: translate_unary(REG_SIZEOF); break;
+
+        case OP_JUMP: materialize(0); emit_jump(REG_JUMP, read_uint32(translator.ip), 0, 0); break;
+        case OP_JUMP_IF_FALSE: translate_jump_if_false(read_uint32(translator.ip)); break;
+
+        case OP_ADD: translate_binary(REG_ADD); break;
+        case OP_SUB: translate_binary(REG_SUB); break;
+        case OP_ADD_ASSIGN: translate_assign(REG_ADD_ASSIGN, true); break;
+        case OP_SUB_ASSIGN: translate_assign(REG_SUB_ASSIGN, true); break;
+        case OP_MUL: translate_binary(REG_MUL); break;
+        case OP_DIV: translate_binary(REG_DIV); break;
+        case OP_DIV_FLOOR: translate_binary(REG_DIV_FLOOR); break;
+        case OP_NEG: translate_unary(REG_NEG); break;
+
+        case OP_CMP_EQ: translate_binary(REG_CMP_EQ); break;
+        case OP_CMP_NE: translate_binary(REG_CMP_NE); break;
+        case OP_CMP_LT: translate_binary(REG_CMP_LT); break;
+        case OP_CMP_LE: translate_binary(REG_CMP_LE); break;
+        case OP_CMP_GT: translate_binary(REG_CMP_GT); break;
+        case OP_CMP_GE: translate_binary(REG_CMP_GE); break;
+
+        case OP_AND: translate_binary(REG_AND); break;
+        case OP_OR: translate_binary(REG_OR); break;
+
+        case OP_PRINT: emit(REG_PRINT, stack_pop_operand(), 0, 0); break;
+        case OP_ENDL: emit(REG_ENDL, 0, 0, 0); break;
+        case OP_STACK_CLEAR: translator.depth -= translator.bytecode->instructions[translator.ip]; break;
+
+        default: {
+            error_throw(ERROR_RUNTIME, "Unknown instruction found during register translation", translator.line);
+            break;
+        }
+    }
+
+    translator.ip += instruction_operand_size(instruction);
+}
+
+static void translate_unit(translation_unit_t unit) {
+    register_function_t* function = unit.function < 0 ? NULL : &rvm.functions[unit.function];
+
+    translator.ip = unit.start;
+    translator.local_count = function == NULL ? 0 : function->local_count;
+    translator.depth = 0;
+    translator.max_depth = 0;
+    translator.last_result = -1;
+
+    if (function != NULL) {
+        function->entry = rvm.code->count;
+    }
+
+    if (unit.is_object) {
+        // register 0 of an object body holds the object being initialized, which stays on the stack
+        stack_push_operand(0);
+    }
+
+    while (translator.ip < unit.end) {
+        translator.line = translator.bytecode->lines[translator.ip];
+
+        if (translator.jump_targets[translator.ip]) {
+            materialize(0);
+            translator.last_result = -1;
+        }
+
+        translator.code_by_ip[translator.ip] = rvm.code->count;
+        byte_t instruction = translator.bytecode->instructions[translator.ip++];
+        translate_instruction(instruction);
+    }
+
+    translator.code_by_ip[unit.end] = rvm.code->count;
+
+    if (unit.function < 0) {
+        emit(REG_HALT, 0, 0, 0);
+    }
+
+    if (function != NULL) {
+        function->frame_size = translator.local_count + translator.max_depth;
+    } else {
+        rvm.top_level_frame_size = translator.max_depth;
+    }
+}
+
+static void translate(bytecode_t* bytecode) {
+    translator.bytecode = bytecode;
+    translator.jump_targets = (bool*)calloc(bytecode->count + 1, sizeof(bool));
+    translator.code_by_ip = (int*)calloc(bytecode->count + 1, sizeof(int));
+    translator.fixup_count = 0;
+    translator.unit_count = 0;
+
+    rvm.function_by_ip = (int*)malloc((bytecode->count + 1) * sizeof(int));
+
+    for (int ip = 0; ip <= bytecode->count; ip++) {
+        rvm.function_by_ip[ip] = -1;
+    }
+
+    for (int ip = 0; ip < bytecode->count; ip += 1 + instruction_operand_size(bytecode->instructions[ip])) {
+        byte_t instruction = bytecode->instructions[ip];
+
+        if (instruction == OP_JUMP || instruction == OP_JUMP_IF_FALSE) {
+            translator.jump_targets[bytes_to_uint32(&bytecode->instructions[ip + 1])] = true;
+        }
+    }
+
+    // the top level code is translated first and is followed by every function and object body it declares
+    push_unit((translation_unit_t){ .start = 0, .end = bytecode->count, .function = -1, .is_object = false });
+
+    for (int i = 0; i < translator.unit_count; i++) {
+        translate_unit(translator.units[i]);
+    }
+
+    for (int i = 0; i < translator.fixup_count; i++) {
+        jump_fixup_t fixup = translator.fixups[i];
+        rvm.code->instructions[fixup.code_index].a = translator.code_by_ip[fixup.target_ip];
+    }
+
+    free(translator.jump_targets);
+    free(translator.code_by_ip);
+    free(translator.fixups);
+    free(translator.units);
+
+    translator.fixups = NULL;
+    translator.units = NULL;
+    translator.fixup_capacity = 0;
+    translator.unit_capacity = 0;
+}
+
+// VIRTUAL MACHINE
+
+void register_vm_init(bytecode_t* bytecode) {
+    register_code_free(rvm.code);
+    free(rvm.functions);
+    free(rvm.function_by_ip);
+    free(rvm.objects);
+    free(rvm.globals);
+    free(rvm.caches);
+    free(rvm.cache_identifiers);
+
+    rvm.code = register_code_init();
+    rvm.functions = NULL;
+    rvm.function_count = 0;
+    rvm.function_capacity = 0;
+    rvm.object_count = compiler_get_object_count();
+    rvm.objects = (int*)malloc((rvm.object_count + 1) * sizeof(int));
+    rvm.templates = compiler_get_templates();
+
+    rvm.global_count = compiler_get_global_count();
+    rvm.globals = (value_t*)malloc((rvm.global_count + 1) * sizeof(value_t));
+
+    for (int i = 0; i < rvm.global_count; i++) {
+        rvm.globals[i] = number(0);
+    }
+
+    natives_install(rvm.globals, compiler_get_native_count());
+
+    rvm.caches = (inline_cache_t*)calloc(compiler_get_cache_count() + 1, sizeof(inline_cache_t));
+    rvm.cache_identifiers = (int*)malloc((compiler_get_cache_count() + 1) * sizeof(int));
+
+    if (rvm.registers == NULL) {
+        rvm.registers = (value_t*)malloc(REGISTER_FILE_SIZE * sizeof(value_t));
+    }
+
+    rvm.frame_top = rvm.frames;
+    rvm.pool = compiler_get_pool();
+
+    translate(bytecode);
+
+    output_free(output);
+    output = output_init();
+}
+
+#define RK(operand) ((operand) >= 0 ? registers[(operand)] : constants[-(operand) - 1])
+#define LINE() (rvm.code->lines[instruction - rvm.code->instructions])
+
+#ifdef DEBUG
+#define DISPATCH() do { instruction = pc++; printf("Running register instruction %d on pc %ld\n", instruction->op, (long)(instruction - rvm.code->instructions)); goto *dispatch_table[instruction->op]; } while (0)
+#else
+#define DISPATCH() do { instruction = pc++; goto *dispatch_table[instruction->op]; } while (0)
+#endif
+
+// collections only happen at jumps, calls and object instantiations, where every live value is in a register
+#define SAFEPOINT() do { if (memory_collection_requested) memory_collect(mark_roots); } while (0)
+
+#ifdef TYPE_CHECKING
+#define EXPECT_NUMBERS(left, right) \
+    if (!IS_NUMBER(left) || !IS_NUMBER(right)) { \
+        error_throw(ERROR_RUNTIME, "Expected operands to be numbers", LINE()); \
+    }
+#define EXPECT_BOOLEAN(value) \
+    if (!IS_BOOLEAN(value)) { \
+        error_throw(ERROR_RUNTIME, "Expected operand to be a boolean", LINE()); \
+    }
+#else
+#define EXPECT_NUMBERS(left, right)
+#define EXPECT_BOOLEAN(value)
+#endif
+
+static inline value_t call_native(native_t* native, value_t* args, int arg_count, int line) {
+    if (native->arity != arg_count) {
+        error_throw(ERROR_RUNTIME, "Wrong number of arguments in function call", line);
+    }
+
+    return native->function(args, line);
+}
+
+static inline register_function_t* function_from_value(value_t value, int line) {
+    long ip = (long)AS_NUMBER(value);
+
+    if (!IS_NUMBER(value) || ip < 0 || ip > translator.bytecode->count || rvm.function_by_ip[ip] < 0) {
+        error_throw(ERROR_RUNTIME, "Expected a function to call", line);
+        return NULL;
+    }
+
+    return &rvm.functions[rvm.function_by_ip[ip]];
+}
+
+// registers of the new frame that are not already initialized are cleared, so that every register below
+// registers_top holds a live or harmless value when the garbage collector scans the register file
+static inline void push_frame(register_instruction_t* return_pc, value_t* registers, value_t* result, value_t* base, register_function_t* function, int initialized, int line) {
+    if (rvm.frame_top == rvm.frames + REGISTER_CALL_STACK_SIZE) {
+        error_throw(ERROR_RUNTIME, "Call stack overflow", line);
+    }
+
+    value_t* frame_end = base + function->frame_size;
+
+    if (frame_end > rvm.registers + REGISTER_FILE_SIZE) {
+        error_throw(ERROR_RUNTIME, "Register file overflow", line);
+    }
+
+    // parameters are variables of the callee, so they own their arguments
+    for (value_t* slot = base; slot < base + initialized; slot++) {
+        value_retain(*slot);
+    }
+
+    for (value_t* slot = base + initialized; slot < frame_end; slot++) {
+        *slot = number(0);
+    }
+
+    *rvm.frame_top++ = (register_frame_t){ .return_pc = return_pc, .registers = registers, .registers_top = rvm.registers_top, .result = result };
+
+    if (frame_end > rvm.registers_top) {
+        rvm.registers_top = frame_end;
+    }
+}
+
+static void mark_roots() {
+    memory_mark_values(rvm.registers, rvm.registers_top - rvm.registers);
+    memory_mark_values(rvm.globals, rvm.global_count);
+    memory_mark_values(rvm.pool->values, rvm.pool->count);
+
+    for (int i = 0; i < rvm.object_count; i++) {
+        if (rvm.templates[i].shape != NULL) {
+            memory_mark_values(rvm.templates[i].slots, rvm.templates[i].shape->count);
+        }
+    }
+}
+
+void register_vm_run(bool test) {
+    is_testing = test;
+
+    static void* dispatch_table[] = {
+        &&label_move,                   // REG_MOVE
+        &&label_store_local,            // REG_STORE_LOCAL
+        &&label_load_global,            // REG_LOAD_GLOBAL
+        &&label_store_global,           // REG_STORE_GLOBAL
+
+        &&label_func_def,               // REG_FUNC_DEF
+        &&label_call,                   // REG_CALL
+        &&label_call_direct,            // REG_CALL_DIRECT
+        &&label_return,                 // REG_RETURN
+
+        &&label_enum_def,               // REG_ENUM_DEF
+        &&label_enum_item,              // REG_ENUM_ITEM
+
+        &&label_new_obj,                // REG_NEW_OBJ
+        &&label_clone_obj,              // REG_CLONE_OBJ
+        &&label_obj_end,                // REG_OBJ_END
+        &&label_load_prop,              // REG_LOAD_PROP
+        &&label_load_prop_separate,     // REG_LOAD_PROP_SEPARATE
+        &&label_store_prop,             // REG_STORE_PROP
+
+        &&label_array_def,              // REG_ARRAY_DEF
+        &&label_array_get,              // REG_ARRAY_GET
+        &&label_array_get_separate,     // REG_ARRAY_GET_SEPARATE
+        &&label_array_set,              // REG_ARRAY_SET
+        &&label_separate,               // REG_SEPARATE
+        &&label_slice,                  // REG_SLICE
+        &&label_map_def,                // REG_MAP_DEF
+
+        &&label_sizeof,                 // REG_SIZEOF
+
+        &&label_jump,                   // REG_JUMP
+        &&label_jump_if_false,          // REG_JUMP_IF_FALSE
+        &&label_jump_if_not_eq,         // REG_JUMP_IF_NOT_EQ
+        &&label_jump_if_not_ne,         // REG_JUMP_IF_NOT_NE
+        &&label_jump_if_not_lt,         // REG_JUMP_IF_NOT_LT
+        &&label_jump_if_not_le,         // REG_JUMP_IF_NOT_LE
+        &&label_jump_if_not_gt,         // REG_JUMP_IF_NOT_GT
+        &&label_jump_if_not_ge,         // REG_JUMP_IF_NOT_GE
+
+        &&label_add,                    // REG_ADD
+        &&label_sub,                    // REG_SUB
+        &&label_add_assign,             // REG_ADD_ASSIGN
+        &&label_sub_assign,             // REG_SUB_ASSIGN
+        &&label_mul,                    // REG_MUL
+        &&label_div,                    // REG_DIV
+        &&label_div_floor,              // REG_DIV_FLOOR
+        &&label_neg,                    // REG_NEG
+
+        &&label_cmp_eq,                 // REG_CMP_EQ
+        &&label_cmp_ne,                 // REG_CMP_NE
+        &&label_cmp_lt,                 // REG_CMP_LT
+        &&label_cmp_le,                 // REG_CMP_LE
+        &&label_cmp_gt,                 // REG_CMP_GT
+        &&label_cmp_ge,                 // REG_CMP_GE
+
+        &&label_and,                    // REG_AND
+        &&label_or,                     // REG_OR
+
+        &&label_print,                  // REG_PRINT
+        &&label_endl,                   // REG_ENDL
+
+        &&label_halt,                   // REG_HALT
+    };
+
+    register_instruction_t* pc = rvm.code->instructions;
+    register_instruction_t* instruction;
+    value_t* registers = rvm.registers;
+    value_t* constants = rvm.pool->values;
+
+    rvm.frame_top = rvm.frames;
+    rvm.registers_top = rvm.registers + rvm.top_level_frame_size;
+
+    for (value_t* slot = rvm.registers; slot < rvm.registers_top; slot++) {
+        *slot = number(0);
+    }
+
+    DISPATCH();
+
+    label_move:
+        registers[instruction->a] = RK(instruction->b);
+        DISPATCH();
+    label_store_local:
+        value_store(&registers[instruction->a], RK(instruction->b));
+        DISPATCH();
+    label_load_global:
+        registers[instruction->a] = rvm.globals[instruction->b];
+        DISPATCH();
+    label_store_global:
+        value_store(&rvm.globals[instruction->a], RK(instruction->b));
+        DISPATCH();
+
+    label_func_def:
+        rvm.globals[instruction->a] = number(instruction->b);
+        DISPATCH();
+    label_call: {
+        value_t* base = &registers[instruction->a + 1];
+
+        if (IS_NATIVE(registers[instruction->a])) {
+            registers[instruction->a] = call_native(AS_NATIVE(registers[instruction->a]), base, instruction->b, LINE());
+            SAFEPOINT();
+            DISPATCH();
+        }
+
+        register_function_t* function = function_from_value(registers[instruction->a], LINE());
+
+        if (function->param_count != instruction->b) {
+            error_throw(ERROR_RUNTIME, "Wrong number of arguments in function call", LINE());
+        }
+
+        push_frame(pc, registers, &registers[instruction->a], base, function, instruction->b, LINE());
+
+        registers = base;
+        pc = rvm.code->instructions + function->entry;
+        SAFEPOINT();
+        DISPATCH();
+    }
+    label_call_direct: {
+        value_t* base = &registers[instruction->a];
+
+        if (IS_NATIVE(rvm.globals[instruction->c])) {
+            *base = call_native(AS_NATIVE(rvm.globals[instruction->c]), base, instruction->b, LINE());
+            SAFEPOINT();
+            DISPATCH();
+        }
+
+        register_function_t* function = function_from_value(rvm.globals[instruction->c], LINE());
+
+        if (function->param_count != instruction->b) {
+            error_throw(ERROR_RUNTIME, "Wrong number of arguments in function call", LINE());
+        }
+
+        push_frame(pc, registers, base, base, function, instruction->b, LINE());
+
+        registers = base;
+        pc = rvm.code->instructions + function->entry;
+        SAFEPOINT();
+        DISPATCH();
+    }
+    label_return: {
+        value_t value = RK(instruction->a);
+        register_frame_t* frame = --rvm.frame_top;
+
+        *frame->result = value;
+        registers = frame->registers;
+        rvm.registers_top = frame->registers_top;
+        pc = frame->return_pc;
+        DISPATCH();
+    }
+
+    label_enum_def: {
+        enum_t* enumeration = enum_init();
+
+        for (int i = 0; i < instruction->b; i++) {
+            table_set(enumeration->values, AS_STRING(constants[pc[i].a]), number(i));
+        }
+
+        rvm.globals[instruction->a] = ENUM_VALUE(enumeration);
+        pc += instruction->b;
+        DISPATCH();
+    }
+    label_enum_item:
+        DISPATCH();
+
+    label_new_obj: {
+        register_function_t* function = &rvm.functions[rvm.objects[instruction->b]];
+        value_t* base = &registers[instruction->a];
+
+        *base = OBJECT_VALUE(object_init());
+
+        push_frame(pc, registers, NULL, base, function, 1, LINE());
+
+        registers = base;
+        pc = rvm.code->instructions + function->entry;
+        SAFEPOINT();
+        DISPATCH();
+    }
+    label_clone_obj: {
+        object_template_t* template = &rvm.templates[instruction->b];
+
+        registers[instruction->a] = OBJECT_VALUE(object_clone(template->shape, template->slots));
+        SAFEPOINT();
+        DISPATCH();
+    }
+    label_obj_end: {
+        register_frame_t* frame = --rvm.frame_top;
+
+        registers = frame->registers;
+        rvm.registers_top = frame->registers_top;
+        pc = frame->return_pc;
+        DISPATCH();
+    }
+    label_load_prop:
+        registers[instruction->a] = operation_load_prop(RK(instruction->b), constants[rvm.cache_identifiers[instruction->c]], &rvm.caches[instruction->c], LINE());
+        DISPATCH();
+    label_load_prop_separate:
+        registers[instruction->a] = operation_load_prop_separate(RK(instruction->b), constants[rvm.cache_identifiers[instruction->c]], &rvm.caches[instruction->c], LINE());
+        DISPATCH();
+    label_store_prop:
+        operation_store_prop(RK(instruction->a), constants[rvm.cache_identifiers[instruction->b]], RK(instruction->c), &rvm.caches[instruction->b], LINE());
+        DISPATCH();
+
+    label_array_def:
+        registers[instruction->a] = operation_array_def(&registers[instruction->a], instruction->b);
+        DISPATCH();
+    label_array_get:
+        registers[instruction->a] = operation_array_get(RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_array_get_separate:
+        registers[instruction->a] = operation_array_get_separate(RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_array_set:
+        operation_array_set(RK(instruction->a), RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_separate: {
+        value_t value = operation_separate(RK(instruction->b));
+
+        if (instruction->a == instruction->b) {
+            value_store(&registers[instruction->a], value);
+        } else {
+            registers[instruction->a] = value;
+        }
+        DISPATCH();
+    }
+    label_slice:
+        registers[instruction->a] = operation_slice(registers[instruction->a], registers[instruction->a + 1], registers[instruction->a + 2], LINE());
+        DISPATCH();
+    label_map_def:
+        registers[instruction->a] = operation_map_def(&registers[instruction->a], instruction->b, LINE());
+        DISPATCH();
+
+    label_sizeof:
+        registers[instruction->a] = operation_sizeof(RK(instruction->b), LINE());
+        DISPATCH();
+
+    label_jump:
+        pc = rvm.code->instructions + instruction->a;
+        SAFEPOINT();
+        DISPATCH();
+    label_jump_if_false: {
+        value_t value = RK(instruction->b);
+        EXPECT_BOOLEAN(value);
+
+        if (!AS_BOOLEAN(value)) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+    label_jump_if_not_eq: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        bool result = IS_NUMBER(left) && IS_NUMBER(right)
+            ? AS_NUMBER(left) == AS_NUMBER(right)
+            : AS_BOOLEAN(operation_cmp_eq(left, right, LINE()));
+
+        if (!result) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+    label_jump_if_not_ne: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        bool result = IS_NUMBER(left) && IS_NUMBER(right)
+            ? AS_NUMBER(left) != AS_NUMBER(right)
+            : AS_BOOLEAN(operation_cmp_ne(left, right, LINE()));
+
+        if (!result) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+    label_jump_if_not_lt: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        if (!(AS_NUMBER(left) < AS_NUMBER(right))) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+    label_jump_if_not_le: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        if (!(AS_NUMBER(left) <= AS_NUMBER(right))) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+    label_jump_if_not_gt: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        if (!(AS_NUMBER(left) > AS_NUMBER(right))) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+    label_jump_if_not_ge: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        if (!(AS_NUMBER(left) >= AS_NUMBER(right))) {
+            pc = rvm.code->instructions + instruction->a;
+        }
+        DISPATCH();
+    }
+
+    label_add: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+
+        if (IS_NUMBER(left) && IS_NUMBER(right)) {
+            registers[instruction->a] = number(AS_NUMBER(left) + AS_NUMBER(right));
+        } else {
+            registers[instruction->a] = operation_add(left, right, LINE());
+        }
+        DISPATCH();
+    }
+    label_sub: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+
+        if (IS_NUMBER(left) && IS_NUMBER(right)) {
+            registers[instruction->a] = number(AS_NUMBER(left) - AS_NUMBER(right));
+        } else {
+            registers[instruction->a] = operation_sub(left, right, LINE());
+        }
+        DISPATCH();
+    }
+    label_add_assign: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+
+        if (IS_NUMBER(left) && IS_NUMBER(right)) {
+            registers[instruction->a] = number(AS_NUMBER(left) + AS_NUMBER(right));
+        } else if (instruction->a == instruction->b) {
+            value_store(&registers[instruction->a], operation_add_assign(left, right, LINE()));
+        } else {
+            registers[instruction->a] = operation_add_assign(left, right, LINE());
+        }
+        DISPATCH();
+    }
+    label_sub_assign: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+
+        if (IS_NUMBER(left) && IS_NUMBER(right)) {
+            registers[instruction->a] = number(AS_NUMBER(left) - AS_NUMBER(right));
+        } else if (instruction->a == instruction->b) {
+            value_store(&registers[instruction->a], operation_sub_assign(left, right, LINE()));
+        } else {
+            registers[instruction->a] = operation_sub_assign(left, right, LINE());
+        }
+        DISPATCH();
+    }
+    label_mul: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        registers[instruction->a] = number(AS_NUMBER(left) * AS_NUMBER(right));
+        DISPATCH();
+    }
+    label_div:
+        registers[instruction->a] = operation_div(RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_div_floor:
+        registers[instruction->a] = operation_div_floor(RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_neg:
+        registers[instruction->a] = operation_neg(RK(instruction->b), LINE());
+        DISPATCH();
+
+    label_cmp_eq:
+        registers[instruction->a] = operation_cmp_eq(RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_cmp_ne:
+        registers[instruction->a] = operation_cmp_ne(RK(instruction->b), RK(instruction->c), LINE());
+        DISPATCH();
+    label_cmp_lt: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        registers[instruction->a] = boolean(AS_NUMBER(left) < AS_NUMBER(right));
+        DISPATCH();
+    }
+    label_cmp_le: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        registers[instruction->a] = boolean(AS_NUMBER(left) <= AS_NUMBER(right));
+        DISPATCH();
+    }
+    label_cmp_gt: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        registers[instruction->a] = boolean(AS_NUMBER(left) > AS_NUMBER(right));
+        DISPATCH();
+    }
+    label_cmp_ge: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_NUMBERS(left, right);
+
+        registers[instruction->a] = boolean(AS_NUMBER(left) >= AS_NUMBER(right));
+        DISPATCH();
+    }
+
+    label_and: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_BOOLEAN(left);
+        EXPECT_BOOLEAN(right);
+
+        registers[instruction->a] = boolean(AS_BOOLEAN(left) && AS_BOOLEAN(right));
+        DISPATCH();
+    }
+    label_or: {
+        value_t left = RK(instruction->b);
+        value_t right = RK(instruction->c);
+        EXPECT_BOOLEAN(left);
+        EXPECT_BOOLEAN(right);
+
+        registers[instruction->a] = boolean(AS_BOOLEAN(left) || AS_BOOLEAN(right));
+        DISPATCH();
+    }
+
+    label_print:
+        if (is_testing) {
+            output_add(output, RK(instruction->a));
+        } else {
+            operation_print(RK(instruction->a));
+        }
+        DISPATCH();
+    label_endl:
+        if (!is_testing) {
+            printf("\n");
+        }
+        DISPATCH();
+
+    label_halt:
+        return;
+}
@@ -7,10 +7,13 @@
 #include "compiler/instruction.h"
 #include "utils/common.h"
 #include "utils/error.h"
+#include "utils/memory.h"
 #include "vm/callstack.h"
 #include "vm/vm.h"
+#include "vm/natives.h"
 #include "vm/pool.h"
 #include "vm/output.h"
+#include "vm/operations.h"
 
 //#define DEBUG
 #define TYPE_CHECKING
@@ -46,31 +49,35 @@ static inline byte_t has_next() {
     return vm.ip < vm.bytecode->count;
 }
 
-static inline value_t number(double number) {
-    value_t value;
-    value.type = TYPE_NUMBER;
-    value.as.number = number;
+static inline uint16_t next_uint16() {
+    uint16_t value = bytes_to_uint16(&vm.bytecode->instructions[vm.ip]);
+    vm.ip += 2;
     return value;
 }
 
-static inline value_t boolean(bool boolean) {
-    value_t value;
-    value.type = TYPE_BOOLEAN;
-    value.as.boolean = boolean;
+static inline uint32_t next_uint32() {
+    uint32_t value = bytes_to_uint32(&vm.bytecode->instructions[vm.ip]);
+    vm.ip += 4;
     return value;
 }
 
+static inline value_t number(double number) {
+    return NUMBER_VALUE(number);
+}
+
+static inline value_t boolean(bool boolean) {
+    return BOOLEAN_VALUE(boolean);
+}
+
 static inline value_t string(char* string) {
-    value_t value;
-    value.type = TYPE_STRING;
-    value.as.string = string;
-    return value;
+    return STRING_VALUE(string);
 }
 
 static void run_load_const();
-static void run_declare_var();
-static void run_load_var();
-static void run_store_var();
+static void run_load_global();
+static void run_store_global();
+static void run_load_local();
+static void run_store_local();
 static void run_func_def();
 static void run_func_end();
 static void run_enum_def();
@@ -78,21 +85,29 @@ static void run_enum_end();
 static void run_store_enum();
 static void run_return();
 static void run_call();
+static void run_call_direct();
 static void run_obj_def();
 static void run_obj_end();
 static void run_new_obj();
 static void run_load_prop();
 static void run_load_prop_const();
+static void run_load_prop_separate();
 static void run_store_prop();
 static void run_init_prop();
 static void run_array_def();
 static void run_array_get();
+static void run_array_get_separate();
 static void run_array_set();
+static void run_separate();
+static void run_slice();
+static void run_map_def();
 static void run_sizeof();
 static void run_jump_if_false();
 static void run_jump();
 static void run_add();
 static void run_sub();
+static void run_add_assign();
+static void run_sub_assign();
 static void run_mul();
 static void run_div();
 static void run_div_floor();
@@ -107,16 +122,13 @@ static void run_and();
 static void run_or();
 static void run_print();
 static void run_endl();
-static void run_print_numeric_literal(value_t* value);
-static void run_print_boolean_literal(value_t* value);
-static void run_print_string_literal(value_t* value);
 static void run_stack_clear();
 
 // STACK
 
 static inline void stack_push(value_t value) {
-    if (vm.stack_top == vm.stack + 256) {
-        error_throw(ERROR_RUNTIME, "Stack overflow (max capacity = 256)", line());
+    if (vm.stack_top == vm.stack + VALUE_STACK_SIZE) {
+        error_throw(ERROR_RUNTIME, "Stack overflow", line());
     }
 
     *vm.stack_top = value;
@@ -132,7 +144,7 @@ static inline value_t stack_pop_number() {
     value_t value = stack_pop();
 
     #ifdef TYPE_CHECKING
-    if (value.type != TYPE_NUMBER) {
+    if (!IS_NUMBER(value)) {
         error_throw(ERROR_RUNTIME, "Expected stack top to be a number", line());
     }
     #endif
@@ -144,7 +156,7 @@ static inline value_t stack_pop_boolean() {
     value_t value = stack_pop();
 
     #ifdef TYPE_CHECKING
-    if (value.type != TYPE_BOOLEAN) {
+    if (!IS_BOOLEAN(value)) {
         error_throw(ERROR_RUNTIME, "Expected stack top to be a boolean", line());
     }
     #endif
@@ -156,7 +168,7 @@ static inline value_t stack_pop_string() {
     value_t value = stack_pop();
     
     #ifdef TYPE_CHECKING
-    if (value.type != TYPE_STRING) {
+    if (!IS_STRING(value)) {
         error_throw(ERROR_RUNTIME, "Expected stack top to be a string", line());
     }
     #endif
@@ -168,7 +180,7 @@ static inline value_t stack_pop_object() {
     value_t value = stack_pop();
     
     #ifdef TYPE_CHECKING
-    if (value.type != TYPE_OBJECT) {
+    if (!IS_OBJECT(value)) {
         error_throw(ERROR_RUNTIME, "Expected stack top to be an object", line());
     }
     #endif
@@ -180,7 +192,7 @@ static inline value_t stack_pop_array() {
     value_t value = stack_pop();
     
     #ifdef TYPE_CHECKING
-    if (value.type != TYPE_ARRAY) {
+    if (!IS_ARRAY(value)) {
         error_throw(ERROR_RUNTIME, "Expected stack top to be an array", line());
     }
     #endif
@@ -188,16 +200,53 @@ static inline value_t stack_pop_array() {
     return value;
 }
 
+// GARBAGE COLLECTION
+
+static void mark_roots() {
+    memory_mark_values(vm.stack, vm.stack_top - vm.stack);
+    memory_mark_values(vm.globals, vm.global_count);
+    memory_mark_values(vm.pool->values, vm.pool->count);
+
+    for (int i = 0; i < vm.object_count; i++) {
+        if (vm.templates[i].shape != NULL) {
+            memory_mark_values(vm.templates[i].slots, vm.templates[i].shape->count);
+        }
+    }
+}
+
+// collections only happen at jumps, calls and object instantiations, where every live value is on the stack
+static inline void safepoint() {
+    if (memory_collection_requested) {
+        memory_collect(mark_roots);
+    }
+}
+
 // VIRTUAL MACHINE
 
 void vm_init(bytecode_t* bytecode) {
     vm.bytecode = bytecode;
     vm.ip = 0;
-    vm.stack_top = vm.stack;
 
-    vm.var_table = table_init(50);
-    vm.func_table = table_init(50);
-    vm.obj_table = table_init(50);
+    vm.global_count = compiler_get_global_count();
+    vm.globals = (value_t*)malloc(vm.global_count * sizeof(value_t));
+
+    for (int i = 0; i < vm.global_count; i++) {
+        vm.globals[i] = number(0);
+    }
+
+    natives_install(vm.globals, compiler_get_native_count());
+
+    vm.object_count = compiler_get_object_count();
+    vm.objects = (long*)malloc(vm.object_count * sizeof(long));
+    vm.templates = compiler_get_templates();
+    vm.caches = (inline_cache_t*)calloc(compiler_get_cache_count() + 1, sizeof(inline_cache_t));
+
+    if (vm.stack == NULL) {
+        vm.stack = (value_t*)malloc(VALUE_STACK_SIZE * sizeof(value_t));
+    }
+
+    vm.stack_top = vm.stack;
+    vm.locals = vm.stack;
 
     vm.call_stack = call_stack_init();
     vm.pool = compiler_get_pool();
@@ -212,14 +261,16 @@ void vm_run(bool test) {
     static void* dispatch_table[] = {
         &&label_load_const,             // OP_LOAD_CONST
 
-        &&label_declare_var,            // OP_DECLARE_VAR
-        &&label_load_var,               // OP_LOAD_VAR
-        &&label_store_var,              // OP_STORE_VAR
+        &&label_load_global,            // OP_LOAD_GLOBAL
+        &&label_store_global,           // OP_STORE_GLOBAL
+        &&label_load_local,             // OP_LOAD_LOCAL
+        &&label_store_local,            // OP_STORE_LOCAL
 
         &&label_func_def,               // OP_FUNC_DEF
         &&label_func_end,               // OP_FUNC_END
         &&label_return,                 // OP_RETURN
         &&label_call,                   // OP_CALL
+        &&label_call_direct,            // OP_CALL_DIRECT
 
         &&label_enum_def,               // OP_ENUM_DEF
         &&label_store_enum,             // OP_STORE_ENUM
@@ -230,12 +281,17 @@ void vm_run(bool test) {
         &&label_new_obj,                // OP_NEW_OBJ
         &&label_load_prop,              // OP_LOAD_PROP
         &&label_load_prop_const,        // OP_LOAD_PROP_CONST
+        &&label_load_prop_separate,     // OP_LOAD_PROP_SEPARATE
         &&label_store_prop,             // OP_STORE_PROP
         &&label_init_prop,              // OP_INIT_PROP
 
         &&label_array_def,              // OP_ARRAY_DEF
         &&label_array_get,              // OP_ARRAY_GET
+        &&label_array_get_separate,     // OP_ARRAY_GET_SEPARATE
         &&label_array_set,              // OP_ARRAY_SET
+        &&label_separate,               // OP_SEPARATE
+        &&label_slice,                  // OP_SLICE
+        &&label_map_def,                // OP_MAP_DEF
 
         &&label_sizeof,                 // OP_SIZE_OF
 
@@ -244,6 +300,8 @@ void vm_run(bool test) {
 
         &&label_add,                    // OP_ADD
         &&label_sub,                    // OP_SUB
+        &&label_add_assign,             // OP_ADD_ASSIGN
+        &&label_sub_assign,             // OP_SUB_ASSIGN
         &&label_mul,                    // OP_MUL
         &&label_div,                    // OP_DIV
         &&label_div_floor,              // OP_DIV_FLOOR
@@ -274,16 +332,20 @@ void vm_run(bool test) {
             run_load_const();
             DISPATCH();
 
-        label_declare_var:
-            run_declare_var();
+        label_load_global:
+            run_load_global();
+            DISPATCH();
+
+        label_store_global:
+            run_store_global();
             DISPATCH();
 
-        label_load_var:
-            run_load_var();
+        label_load_local:
+            run_load_local();
             DISPATCH();
 
-        label_store_var:
-            run_store_var();
+        label_store_local:
+            run_store_local();
             DISPATCH();
 
         label_func_def:
@@ -326,6 +388,10 @@ void vm_run(bool test) {
             run_load_prop_const();
             DISPATCH();
 
+        label_load_prop_separate:
+            run_load_prop_separate();
+            DISPATCH();
+
         label_store_prop:
             run_store_prop();
             DISPATCH();
@@ -342,10 +408,26 @@ void vm_run(bool test) {
             run_array_get();
             DISPATCH();
 
+        label_array_get_separate:
+            run_array_get_separate();
+            DISPATCH();
+
         label_array_set:
             run_array_set();
             DISPATCH();
 
+        label_separate:
+            run_separate();
+            DISPATCH();
+
+        label_slice:
+            run_slice();
+            DISPATCH();
+
+        label_map_def:
+            run_map_def();
+            DISPATCH();
+
         label_sizeof:
             run_sizeof();
             DISPATCH();
@@ -359,6 +441,10 @@ void vm_run(bool test) {
             run_call();
             DISPATCH();
 
+        label_call_direct:
+            run_call_direct();
+            DISPATCH();
+
         label_jump:
             run_jump();
             DISPATCH();
@@ -375,6 +461,14 @@ void vm_run(bool test) {
             run_sub();
             DISPATCH();
 
+        label_add_assign:
+            run_add_assign();
+            DISPATCH();
+
+        label_sub_assign:
+            run_sub_assign();
+            DISPATCH();
+
         label_mul:
             run_mul();
             DISPATCH();
@@ -459,132 +553,57 @@ static void run_load_const() {
     stack_push(*value);
 }
 
-static value_t* load_global_var(char* identifier) {
-    value_t* value = table_get(vm.var_table, identifier);
-
-    if (value != NULL) {
-        return value;
-    }
-
-    value = table_get(vm.func_table, identifier);
-
-    if (value != NULL) {
-        return value;
+static inline void push_call_frame(value_t* stack_top) {
+    if (vm.call_stack->call_frame_top == vm.call_stack->call_frames + CALL_STACK_SIZE) {
+        error_throw(ERROR_RUNTIME, "Call stack overflow", line());
     }
 
-    return NULL;
+    call_stack_push(vm.call_stack, (call_frame_t){.ra = vm.ip, .locals = vm.locals, .stack_top = stack_top});
 }
 
-static value_t* load_local_var(char* identifier) {
-    if (call_stack_current(vm.call_stack) == NULL) {
-        return NULL;
-    }
-
-    return table_get(call_stack_current(vm.call_stack)->table, identifier);
+static inline int function_local_count(long func_ip) {
+    // local count is the last operand of OP_FUNC_DEF directly preceding the function body
+    return bytes_to_uint16(&vm.bytecode->instructions[func_ip - 2]);
 }
 
-static value_t* load_var(char* identifier) {
-    // check for local variables first
-    value_t* local_var = load_local_var(identifier);
-
-    if (local_var != NULL) {
-        return local_var;
-    }
-
-    // if local variable is not found, check for global variables
-    value_t* global_var = load_global_var(identifier);
-
-    if (global_var != NULL) {
-        return global_var;
-    }
-
-    return NULL;
+static inline int function_param_count(long func_ip) {
+    return vm.bytecode->instructions[func_ip - 3];
 }
 
-static void run_declare_var() {
+static void run_load_global() {
     #ifdef DEBUG
-    dump_instruction("run_declare_var");
+    dump_instruction("run_load_global");
     #endif
 
-    value_t identifier = stack_pop_string();
-    value_t value = stack_pop();
-
-    // global variable
-    if (call_stack_current(vm.call_stack) == NULL) {
-        /* if (table_get(vm.var_table, identifier.as.string) != NULL) {
-            error_throw(ERROR_RUNTIME, "Cannot declare a global variable with the same identifier, because it has been already declared", line());
-            return;
-        } */
-
-        table_set(vm.var_table, identifier.as.string, value);
-    }
-    // local variable
-    else {
-        // TODO: fix the removal of local variables within if and while scope
-        /* if (table_get(call_stack_current(vm.call_stack)->table, identifier.as.string) != NULL) {
-            error_throw(ERROR_RUNTIME, "Cannot declare a local variable with the same identifier, because it has been already declared", line());
-            return;
-        } */
-
-        table_set(call_stack_current(vm.call_stack)->table, identifier.as.string, value);
-    }
+    uint16_t index = next_uint16();
+    stack_push(vm.globals[index]);
 }
 
-static void run_load_var() {
+static void run_store_global() {
     #ifdef DEBUG
-    dump_instruction("run_load_var");
+    dump_instruction("run_store_global");
     #endif
 
-    value_t identifier = stack_pop_string();
-    value_t* value = load_var(identifier.as.string);
-
-    if (value == NULL) {
-        error_throw(ERROR_RUNTIME, "Variable with the given identifier does not exist", line());
-        return;
-    }
-
-    stack_push(*value);
+    uint16_t index = next_uint16();
+    value_store(&vm.globals[index], stack_pop());
 }
 
-static void run_store_var() {
+static void run_load_local() {
     #ifdef DEBUG
-    dump_instruction("run_store_var");
+    dump_instruction("run_load_local");
     #endif
 
-    value_t identifier = stack_pop_string();
-    value_t value = stack_pop();
-
-    if (table_get(call_stack_current(vm.call_stack)->table, identifier.as.string) != NULL) {
-        table_set(call_stack_current(vm.call_stack)->table, identifier.as.string, value);
-        return;
-    }
+    uint16_t slot = next_uint16();
+    stack_push(vm.locals[slot]);
+}
 
-    if (table_get(vm.var_table, identifier.as.string) != NULL) {
-        table_set(vm.var_table, identifier.as.string, value);
-        return;
-    }
+static void run_store_local() {
+    #ifdef DEBUG
+    dump_instruction("run_store_local");
+    #endif
 
-    error_throw(ERROR_RUNTIME, "Cannot assign to a variable, becuase it does not exist", line());
-}
-
-static inline void skip_func_def() {
-    while (vm.ip < vm.bytecode->count) {
-        switch (current()) {
-            case OP_LOAD_CONST: {
-                next();
-                vm.ip += 2;
-                break;
-            }
-            case OP_FUNC_END: {
-                next();
-                return;
-            }
-            default: {
-                vm.ip += 1;
-                break;
-            }
-        }
-    }
+    uint16_t slot = next_uint16();
+    value_store(&vm.locals[slot], stack_pop());
 }
 
 static void run_func_def() {
@@ -592,10 +611,13 @@ static void run_func_def() {
     dump_instruction("run_func_def");
     #endif
 
-    value_t identifier = stack_pop_string();
-    table_set(vm.func_table, identifier.as.string, number(vm.ip));
+    uint16_t index = next_uint16();
+    uint32_t end_ip = next_uint32();
+    next();
+    next_uint16();
 
-    skip_func_def();
+    vm.globals[index] = number(vm.ip);
+    vm.ip = end_ip;
 }
 
 static void run_func_end() {
@@ -609,7 +631,7 @@ static void run_enum_def() {
     dump_instruction("run_enum_def");
     #endif
 
-    value_t identifier = stack_pop_string();
+    uint16_t global_index = next_uint16();
     enum_t* enumeration = enum_init();
 
     if (current() == OP_ENUM_END) {
@@ -629,15 +651,10 @@ static void run_enum_def() {
         }
 
         value_t enum_item = stack_pop_string();
-        table_set(enumeration->values, enum_item.as.string, number(index++));
+        table_set(enumeration->values, AS_STRING(enum_item), number(index++));
     }
 
-    value_t enum_value;
-    enum_value.type = TYPE_ENUM;
-    enum_value.as.enumeration = *enumeration;
-
-    // TODO: maybe store enum values to different table? or store them as objects?
-    table_set(vm.var_table, identifier.as.string, enum_value);
+    vm.globals[global_index] = ENUM_VALUE(enumeration);
 }
 
 static void run_enum_end() {
@@ -652,35 +669,16 @@ static void run_store_enum() {
     #endif
 }
 
-static inline void skip_obj_def() {
-    while (vm.ip < vm.bytecode->count) {
-        switch (current()) {
-            case OP_LOAD_CONST: {
-                next();
-                vm.ip += 2;
-                break;
-            }
-            case OP_OBJ_END: {
-                next();
-                return;
-            }
-            default: {
-                vm.ip += 1;
-                break;
-            }
-        }
-    }
-}
-
 static void run_obj_def() {
     #ifdef DEBUG
     dump_instruction("run_obj_def");
     #endif
 
-    value_t identifier = stack_pop_string();
-    table_set(vm.obj_table, identifier.as.string, number(vm.ip));
+    uint16_t index = next_uint16();
+    uint32_t end_ip = next_uint32();
 
-    skip_obj_def();
+    vm.objects[index] = vm.ip;
+    vm.ip = end_ip;
 }
 
 static void run_obj_end() {
@@ -696,7 +694,7 @@ static void run_obj_end() {
     }
 
     vm.ip = call_frame->ra;
-    call_frame_free(call_frame);
+    vm.locals = call_frame->locals;
 }
 
 static void run_new_obj() {
@@ -704,23 +702,25 @@ static void run_new_obj() {
     dump_instruction("run_new_obj");
     #endif
 
-    value_t identifier = stack_pop_string();
-    value_t* object_ip = table_get(vm.obj_table, identifier.as.string);
+    uint16_t index = next_uint16();
+    object_template_t* template = &vm.templates[index];
 
-    if (object_ip == NULL) {
-        error_throw(ERROR_RUNTIME, "Object with the given identifier does not exist", line());
+    if (template->shape != NULL) {
+        stack_push(OBJECT_VALUE(object_clone(template->shape, template->slots)));
+        safepoint();
         return;
     }
 
-    value_t object;
-    object.type = TYPE_OBJECT;
-    object.as.object = *object_init();
+    long object_ip = vm.objects[index];
 
-    // TODO: initialise table size to 0 ??? (it will most probably not be used)
-    call_stack_push(vm.call_stack, (call_frame_t){.ra = vm.ip, .table = table_init(50)});
-    vm.ip = (long)object_ip->as.number;
+    value_t object = OBJECT_VALUE(object_init());
+
+    push_call_frame(vm.stack_top);
+    vm.ip = object_ip;
 
     stack_push(object);
+
+    safepoint();
 }
 
 static void run_load_prop() {
@@ -728,17 +728,11 @@ static void run_load_prop() {
     dump_instruction("run_load_prop");
     #endif
 
+    inline_cache_t* cache = &vm.caches[next_uint16()];
     value_t identifier = stack_pop_string();
     value_t object = stack_pop_object();
 
-    value_t* property = table_get(object.as.object.properties, identifier.as.string);
-
-    if (property == NULL) {
-        error_throw(ERROR_RUNTIME, "Object property with the given identifier does not exist", line());
-    }
-
-    stack_push(object);
-    stack_push(*property);
+    stack_push(operation_load_prop(object, identifier, cache, line()));
 }
 
 static void run_load_prop_const() {
@@ -746,35 +740,23 @@ static void run_load_prop_const() {
     dump_instruction("run_load_prop_const");
     #endif
 
+    inline_cache_t* cache = &vm.caches[next_uint16()];
     value_t identifier = stack_pop_string();
     value_t value = stack_pop();
 
-    switch (value.type) {
-        case TYPE_OBJECT: {
-            value_t* prop = table_get(value.as.object.properties, identifier.as.string);
-
-            if (prop == NULL) {
-                error_throw(ERROR_RUNTIME, "Object property with the given identifier does not exist", line());
-            }
+    stack_push(operation_load_prop(value, identifier, cache, line()));
+}
 
-            stack_push(*prop);
-            break;
-        }
-        case TYPE_ENUM: {
-            value_t* item = table_get(value.as.enumeration.values, identifier.as.string);
+static void run_load_prop_separate() {
+    #ifdef DEBUG
+    dump_instruction("run_load_prop_separate");
+    #endif
 
-            if (item == NULL) {
-                error_throw(ERROR_RUNTIME, "Enum item with the given identifier does not exist", line());
-            }
+    inline_cache_t* cache = &vm.caches[next_uint16()];
+    value_t identifier = stack_pop_string();
+    value_t value = stack_pop();
 
-            stack_push(*item);
-            break;
-        }
-        default: {
-            error_throw(ERROR_RUNTIME, "Unknown datatype in OP_PROP_LOAD_CONST", line());
-            return;
-        }
-    }
+    stack_push(operation_load_prop_separate(value, identifier, cache, line()));
 }
 
 static void run_store_prop() {
@@ -782,20 +764,12 @@ static void run_store_prop() {
     dump_instruction("run_store_prop");
     #endif
 
+    inline_cache_t* cache = &vm.caches[next_uint16()];
     value_t identifier = stack_pop_string();
     value_t value = stack_pop();
     value_t object = stack_pop_object();
 
-    object_add_property(&(object.as.object), identifier.as.string, value);
-
-    // TODO: fix storing to global variable (this currently only stores to local variable)
-    //table_set(call_stack_current(vm.call_stack)->table, identifier.as.string, object);
-
-    if (load_global_var(identifier.as.string) != NULL) {
-        table_set(vm.var_table, identifier.as.string, object);
-    } else {
-        table_set(call_stack_current(vm.call_stack)->table, identifier.as.string, object);
-    }
+    operation_store_prop(object, identifier, value, cache, line());
 }
 
 static void run_init_prop() {
@@ -803,11 +777,12 @@ static void run_init_prop() {
     dump_instruction("run_init_prop");
     #endif
 
+    inline_cache_t* cache = &vm.caches[next_uint16()];
     value_t identifier = stack_pop_string();
     value_t value = stack_pop();
     value_t object = stack_pop_object();
 
-    object_add_property(&(object.as.object), identifier.as.string, value);
+    operation_store_prop(object, identifier, value, cache, line());
 
     stack_push(object);
 }
@@ -817,19 +792,10 @@ static void run_array_def() {
     dump_instruction("run_array_def");
     #endif
 
-    value_t array_size = stack_pop_number();
-    array_t* array = array_init((int)array_size.as.number);
-
-    for (int i = 0; i < (int)array_size.as.number; i++) {
-        int index = ((int)array_size.as.number) - i - 1;
-        array_add_element(array, index, stack_pop());
-    }
-
-    value_t array_value;
-    array_value.type = TYPE_ARRAY;
-    array_value.as.array = *array;
+    int array_size = next_uint16();
+    vm.stack_top -= array_size;
 
-    stack_push(array_value);
+    stack_push(operation_array_def(vm.stack_top, array_size));
 }
 
 static void run_array_get() {
@@ -837,55 +803,65 @@ static void run_array_get() {
     dump_instruction("run_array_get");
     #endif
 
-    value_t index_value = stack_pop_number();
+    value_t index_value = stack_pop();
     value_t array_value = stack_pop();
 
-    int index = (int)index_value.as.number;
+    stack_push(operation_array_get(array_value, index_value, line()));
+}
 
-    if (array_value.type == TYPE_ARRAY) {
-        array_t array = array_value.as.array;
+static void run_array_get_separate() {
+    #ifdef DEBUG
+    dump_instruction("run_array_get_separate");
+    #endif
 
-        if (index >= array.size) {
-            error_throw(ERROR_RUNTIME, "Index out of range", line());
-            return;
-        }
+    value_t index_value = stack_pop();
+    value_t array_value = stack_pop();
 
-        value_t element_value = array_get_element(&array, index);
-        stack_push(element_value);
+    stack_push(operation_array_get_separate(array_value, index_value, line()));
+}
 
-        return;
-    }
+static void run_array_set() {
+    #ifdef DEBUG
+    dump_instruction("run_array_set");
+    #endif
 
-    if (array_value.type == TYPE_STRING) {
-        string_t string_value = array_value.as.string;
+    value_t value = stack_pop();
+    value_t index_value = stack_pop();
+    value_t array_value = stack_pop();
 
-        if (index >= strlen(string_value)) {
-            error_throw(ERROR_RUNTIME, "Index out of range", line());
-            return;
-        }
+    operation_array_set(array_value, index_value, value, line());
+}
 
-        char element_value = string_value[index];
-        char* string_array = (char*)malloc(sizeof(char));
-        string_array[0] = element_value;
+static void run_separate() {
+    #ifdef DEBUG
+    dump_instruction("run_separate");
+    #endif
 
-        stack_push(string(string_array));
-        return;
-    }
+    value_t value = stack_pop();
+    stack_push(operation_separate(value));
+}
 
-    error_throw(ERROR_RUNTIME, "Unsupported value type in OP_ARRAY_GET", line());
+static void run_slice() {
+    #ifdef DEBUG
+    dump_instruction("run_slice");
+    #endif
+
+    value_t end_value = stack_pop_number();
+    value_t start_value = stack_pop_number();
+    value_t string_value = stack_pop();
+
+    stack_push(operation_slice(string_value, start_value, end_value, line()));
 }
 
-static void run_array_set() {
+static void run_map_def() {
     #ifdef DEBUG
-    dump_instruction("run_array_set");
+    dump_instruction("run_map_def");
     #endif
 
-    value_t value = stack_pop();
-    value_t index_value = stack_pop_number();
-    value_t array_value = stack_pop_array();
+    int map_size = next_uint16();
+    vm.stack_top -= 2 * map_size;
 
-    int index = (int)index_value.as.number;
-    array_add_element(&array_value.as.array, index, value);
+    stack_push(operation_map_def(vm.stack_top, map_size, line()));
 }
 
 static void run_sizeof() {
@@ -894,21 +870,52 @@ static void run_sizeof() {
     #endif
 
     value_t value = stack_pop();
+    stack_push(operation_sizeof(value, line()));
+}
 
-    switch (value.type) {
-        case TYPE_STRING: {
-            stack_push(number((double)strlen(value.as.string)));
-            break;
-        }
-        case TYPE_ARRAY: {
-            stack_push(number((double)value.as.array.size));
-            break;
-        }
-        default: {
-            error_throw(ERROR_RUNTIME, "Unsupported datatype in sizeof", line());
-            return;
-        }
+// natives run without a call frame, their result replaces the arguments from result_slot on
+static inline void call_native(native_t* native, int arg_count, value_t* result_slot) {
+    if (native->arity != arg_count) {
+        error_throw(ERROR_RUNTIME, "Wrong number of arguments in function call", line());
+    }
+
+    value_t result = native->function(vm.stack_top - arg_count, line());
+
+    vm.stack_top = result_slot;
+    stack_push(result);
+
+    safepoint();
+}
+
+// the arguments on top of the stack become the first locals of the callee
+static inline void call_function(long func_ip, int arg_count, value_t* stack_top) {
+    if (function_param_count(func_ip) != arg_count) {
+        error_throw(ERROR_RUNTIME, "Wrong number of arguments in function call", line());
     }
+
+    value_t* locals = vm.stack_top - arg_count;
+    value_t* locals_end = locals + function_local_count(func_ip);
+
+    if (locals_end > vm.stack + VALUE_STACK_SIZE) {
+        error_throw(ERROR_RUNTIME, "Stack overflow", line());
+    }
+
+    // parameters are variables of the callee, so they own their arguments
+    for (value_t* slot = locals; slot < vm.stack_top; slot++) {
+        value_retain(*slot);
+    }
+
+    for (value_t* slot = vm.stack_top; slot < locals_end; slot++) {
+        *slot = number(0);
+    }
+
+    push_call_frame(stack_top);
+
+    vm.locals = locals;
+    vm.stack_top = locals_end;
+    vm.ip = func_ip;
+
+    safepoint();
 }
 
 static void run_call() {
@@ -916,21 +923,31 @@ static void run_call() {
     dump_instruction("run_call");
     #endif
 
-    value_t func_arg_count = stack_pop_number();
-    int arg_count = (int)func_arg_count.as.number;
+    int arg_count = next();
+    value_t func_ip = vm.stack_top[-arg_count - 1];
 
-    value_t args[arg_count];
-    for (int i = 0; i < arg_count; i++) {
-        args[i] = stack_pop();
+    if (IS_NATIVE(func_ip)) {
+        call_native(AS_NATIVE(func_ip), arg_count, vm.stack_top - arg_count - 1);
+        return;
     }
 
-    value_t func_ip = stack_pop();
-    call_stack_push(vm.call_stack, (call_frame_t){.ra = vm.ip, .table = table_init(50)});
-    vm.ip = (long)func_ip.as.number;
+    call_function((long)AS_NUMBER(func_ip), arg_count, vm.stack_top - arg_count - 1);
+}
 
-    for (int i = 0; i < arg_count; i++) {
-        stack_push(args[i]);
+static void run_call_direct() {
+    #ifdef DEBUG
+    dump_instruction("run_call_direct");
+    #endif
+
+    uint16_t index = next_uint16();
+    int arg_count = next();
+
+    if (IS_NATIVE(vm.globals[index])) {
+        call_native(AS_NATIVE(vm.globals[index]), arg_count, vm.stack_top - arg_count);
+        return;
     }
+
+    call_function((long)AS_NUMBER(vm.globals[index]), arg_count, vm.stack_top - arg_count);
 }
 
 static void run_return() {
@@ -947,14 +964,14 @@ static void run_return() {
     }
 
     vm.ip = call_frame->ra;
+    vm.locals = call_frame->locals;
+    vm.stack_top = call_frame->stack_top;
     stack_push(return_value);
 
     // exit the virtual machine
     if (call_stack_current(vm.call_stack) == NULL) {
         vm.ip = vm.bytecode->count;
     }
-
-    //call_frame_free(call_frame);
 }
 
 static void run_jump_if_false() {
@@ -962,11 +979,10 @@ static void run_jump_if_false() {
     dump_instruction("run_jump_if_false");
     #endif
 
-    value_t label_index_value = stack_pop_number();
+    uint32_t jump_ip = next_uint32();
     value_t boolean_value = stack_pop_boolean();
 
-    if (boolean_value.as.boolean == false) {
-        long jump_ip = (long)label_index_value.as.number;
+    if (AS_BOOLEAN(boolean_value) == false) {
         vm.ip = jump_ip;
     }
 }
@@ -976,9 +992,9 @@ static void run_jump() {
     dump_instruction("run_jump");
     #endif
 
-    value_t label_index_value = stack_pop_number();
-    long jump_ip = (long)label_index_value.as.number;
-    vm.ip = jump_ip;
+    vm.ip = next_uint32();
+
+    safepoint();
 }
 
 static void run_add() {
@@ -989,55 +1005,60 @@ static void run_add() {
     value_t value1 = stack_pop();
     value_t value2 = stack_pop();
 
-    if (value2.type == TYPE_ARRAY) {
-        array_append(&value2.as.array, value1);
-        stack_push(value2);
-        return;
-    }
-
-    if (value2.type == TYPE_NUMBER && value1.type == TYPE_NUMBER) {
-        stack_push(number(value2.as.number + value1.as.number));
+    if (IS_NUMBER(value2) && IS_NUMBER(value1)) {
+        stack_push(number(AS_NUMBER(value2) + AS_NUMBER(value1)));
         return;
     }
 
-    if (value2.type == TYPE_STRING && value1.type == TYPE_STRING) {
-        char* new_string = (char*)malloc((strlen(value2.as.string) + strlen(value1.as.string)) * sizeof(char));
+    stack_push(operation_add(value2, value1, line()));
+}
 
-        for (int i = 0; i < strlen(value2.as.string); i++) {
-            new_string[i] = value2.as.string[i];
-        }
+static void run_sub() {
+    #ifdef DEBUG
+    dump_instruction("run_sub");
+    #endif
 
-        for (int i = 0; i < strlen(value1.as.string); i++) {
-            new_string[i + strlen(value2.as.string)] = value1.as.string[i];
-        }
+    value_t value1 = stack_pop();
+    value_t value2 = stack_pop();
 
-        stack_push(string(new_string));
+    if (IS_NUMBER(value2) && IS_NUMBER(value1)) {
+        stack_push(number(AS_NUMBER(value2) - AS_NUMBER(value1)));
         return;
     }
 
-    error_throw(ERROR_RUNTIME, "Unknown operands to OP_ADD", line());
+    stack_push(operation_sub(value2, value1, line()));
 }
 
-static void run_sub() {
+static void run_add_assign() {
     #ifdef DEBUG
-    dump_instruction("run_sub");
+    dump_instruction("run_add_assign");
     #endif
 
     value_t value1 = stack_pop();
     value_t value2 = stack_pop();
 
-    if (value2.type == TYPE_ARRAY && value1.type == TYPE_NUMBER) {
-        array_remove(&value2.as.array, (int)value1.as.number);
-        stack_push(value2);
+    if (IS_NUMBER(value2) && IS_NUMBER(value1)) {
+        stack_push(number(AS_NUMBER(value2) + AS_NUMBER(value1)));
         return;
     }
 
-    if (value2.type == TYPE_NUMBER && value1.type == TYPE_NUMBER) {
-        stack_push(number(value2.as.number - value1.as.number));
+    stack_push(operation_add_assign(value2, value1, line()));
+}
+
+static void run_sub_assign() {
+    #ifdef DEBUG
+    dump_instruction("run_sub_assign");
+    #endif
+
+    value_t value1 = stack_pop();
+    value_t value2 = stack_pop();
+
+    if (IS_NUMBER(value2) && IS_NUMBER(value1)) {
+        stack_push(number(AS_NUMBER(value2) - AS_NUMBER(value1)));
         return;
     }
 
-    error_throw(ERROR_RUNTIME, "Unknown operands to OP_SUB", line());
+    stack_push(operation_sub_assign(value2, value1, line()));
 }
 
 static void run_mul() {
@@ -1047,7 +1068,7 @@ static void run_mul() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-    stack_push(number(value2.as.number * value1.as.number));
+    stack_push(number(AS_NUMBER(value2) * AS_NUMBER(value1)));
 }
 
 static void run_div() {
@@ -1057,12 +1078,7 @@ static void run_div() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-
-    if (value2.as.number == 0) {
-        return error_throw(ERROR_RUNTIME, "Division by zero", line());
-    }
-
-    stack_push(number(value2.as.number / value1.as.number));
+    stack_push(operation_div(value2, value1, line()));
 }
 
 static void run_div_floor() {
@@ -1072,12 +1088,7 @@ static void run_div_floor() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-
-    if (value2.as.number == 0) {
-        return error_throw(ERROR_RUNTIME, "Division by zero", line());
-    }
-
-    stack_push(number(floor(value2.as.number / value1.as.number)));
+    stack_push(operation_div_floor(value2, value1, line()));
 }
 
 static void run_neg() {
@@ -1086,21 +1097,7 @@ static void run_neg() {
     #endif
 
     value_t value = stack_pop();
-
-    switch (value.type) {
-        case TYPE_NUMBER: {
-            stack_push(number(-value.as.number));
-            break;
-        }
-        case TYPE_BOOLEAN: {
-            stack_push(boolean(!value.as.boolean));
-            break;
-        }
-        default: {
-            error_throw(ERROR_RUNTIME, "Invalid datatype in negation", line());
-            return;
-        }
-    }
+    stack_push(operation_neg(value, line()));
 }
 
 static void run_cmp_eq() {
@@ -1110,38 +1107,7 @@ static void run_cmp_eq() {
 
     value_t value1 = stack_pop();
     value_t value2 = stack_pop();
-
-    if (value2.type != value1.type) {
-        error_throw(ERROR_RUNTIME, "Cannot cmp_eq two values of different datatypes", line());
-        return;
-    }
-
-    switch (value1.type) {
-        case TYPE_NUMBER: {
-            stack_push(boolean(value2.as.number == value1.as.number));
-            break;
-        }
-        case TYPE_BOOLEAN: {
-            stack_push(boolean(value2.as.boolean == value1.as.boolean));
-            break;
-        }
-        case TYPE_STRING: {
-            size_t strlen1 = strlen(value1.as.string);
-            size_t strlen2 = strlen(value2.as.string);
-
-            if (strlen1 != strlen2) {
-                stack_push(boolean(false));
-                break;
-            }
-
-            bool strings_equal = strcmp(value2.as.string, value1.as.string) == 0;
-            stack_push(boolean(strings_equal));
-            break;
-        }
-        default: {
-            return error_throw(ERROR_RUNTIME, "Unknown datatype for cmp_eq", line());
-        }
-    }
+    stack_push(operation_cmp_eq(value2, value1, line()));
 }
 
 static void run_cmp_ne() {
@@ -1151,38 +1117,7 @@ static void run_cmp_ne() {
 
     value_t value1 = stack_pop();
     value_t value2 = stack_pop();
-
-    if (value2.type != value1.type) {
-        error_throw(ERROR_RUNTIME, "Cannot cmp_ne two values of different datatypes", line());
-        return;
-    }
-
-    switch (value1.type) {
-        case TYPE_NUMBER: {
-            stack_push(boolean(value2.as.number != value1.as.number));
-            break;
-        }
-        case TYPE_BOOLEAN: {
-            stack_push(boolean(value2.as.boolean != value1.as.boolean));
-            break;
-        }
-        case TYPE_STRING: {
-            size_t strlen1 = strlen(value1.as.string);
-            size_t strlen2 = strlen(value2.as.string);
-
-            if (strlen1 != strlen2) {
-                stack_push(boolean(true));
-                break;
-            }
-
-            bool strings_equal = strcmp(value2.as.string, value1.as.string) != 0;
-            stack_push(boolean(strings_equal));
-            break;
-        }
-        default: {
-            return error_throw(ERROR_RUNTIME, "Unknown datatype for cmp_ne", line());
-        }
-    }
+    stack_push(operation_cmp_ne(value2, value1, line()));
 }
 
 static void run_cmp_gt() {
@@ -1192,7 +1127,7 @@ static void run_cmp_gt() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-    stack_push(boolean(value2.as.number > value1.as.number));
+    stack_push(boolean(AS_NUMBER(value2) > AS_NUMBER(value1)));
 }
 
 static void run_cmp_ge() {
@@ -1202,7 +1137,7 @@ static void run_cmp_ge() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-    stack_push(boolean(value2.as.number >= value1.as.number));
+    stack_push(boolean(AS_NUMBER(value2) >= AS_NUMBER(value1)));
 }
 
 static void run_cmp_lt() {
@@ -1212,7 +1147,7 @@ static void run_cmp_lt() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-    stack_push(boolean(value2.as.number < value1.as.number));
+    stack_push(boolean(AS_NUMBER(value2) < AS_NUMBER(value1)));
 }
 
 static void run_cmp_le() {
@@ -1222,7 +1157,7 @@ static void run_cmp_le() {
 
     value_t value1 = stack_pop_number();
     value_t value2 = stack_pop_number();
-    stack_push(boolean(value2.as.number <= value1.as.number));
+    stack_push(boolean(AS_NUMBER(value2) <= AS_NUMBER(value1)));
 }
 
 static void run_and() {
@@ -1232,7 +1167,7 @@ static void run_and() {
 
     value_t value1 = stack_pop_boolean();
     value_t value2 = stack_pop_boolean();
-    stack_push(boolean(value2.as.boolean && value1.as.boolean));
+    stack_push(boolean(AS_BOOLEAN(value2) && AS_BOOLEAN(value1)));
 }
 
 static void run_or() {
@@ -1242,83 +1177,7 @@ static void run_or() {
 
     value_t value1 = stack_pop_boolean();
     value_t value2 = stack_pop_boolean();
-    stack_push(boolean(value2.as.boolean || value1.as.boolean));
-}
-
-static void run_print_newline();
-static void run_print_numeric_literal(value_t* value);
-static void run_print_boolean_literal(value_t* value);
-static void run_print_string_literal(value_t* value);
-static void run_print_array(value_t* value);
-static void run_print_object(value_t* value);
-static void run_print_enum(value_t* value);
-static void run_print_any(value_t* value);
-
-static void run_print_newline() {
-    printf("\n");
-}
-
-static void run_print_numeric_literal(value_t* value) {
-    if (value->as.number == (int)value->as.number) {
-        printf("%d", (int)value->as.number);
-    } else {
-        printf("%.2f", value->as.number);
-    }
-}
-
-static void run_print_boolean_literal(value_t* value) {
-    printf("%s", value->as.boolean ? "true" : "false");
-}
-
-static void run_print_string_literal(value_t* value) {
-    printf("%s", value->as.string);
-}
-
-static void run_print_array(value_t* value) {
-    printf("[");
-
-    for (int i = 0; i < value->as.array.size; i++) {
-        if (value->as.array.elements[i].type == TYPE_STRING) printf("\"");
-        run_print_any(&value->as.array.elements[i]);
-        if (value->as.array.elements[i].type == TYPE_STRING) printf("\"");
-
-        if (i < value->as.array.size - 1) {
-            printf(", ");
-        }
-    }
-
-    printf("]");
-}
-
-static void run_print_object(value_t* value) {
-    printf("[object]: not implemented");
-}
-
-static void run_print_enum(value_t* value) {
-    printf("[enum]: not implemented");
-}
-
-static void run_print_any(value_t* value) {
-    switch (value->type) {
-        case TYPE_NUMBER: {
-            return run_print_numeric_literal(value);
-        }
-        case TYPE_BOOLEAN: {
-            return run_print_boolean_literal(value);
-        }
-        case TYPE_STRING: {
-            return run_print_string_literal(value);
-        }
-        case TYPE_ARRAY: {
-            return run_print_array(value);
-        }
-        case TYPE_OBJECT: {
-            return run_print_object(value);
-        }
-        case TYPE_ENUM: {
-            return run_print_enum(value);
-        }
-    }
+    stack_push(boolean(AS_BOOLEAN(value2) || AS_BOOLEAN(value1)));
 }
 
 static void run_print() {
@@ -1331,7 +1190,7 @@ static void run_print() {
     if (is_testing) {
         output_add(output, value);
     } else {
-        run_print_any(&value);
+        operation_print(value);
     }
 }
 
@@ -1343,8 +1202,8 @@ static void run_endl() {
     if (is_testing) {
         return;
     }
-    
-    run_print_newline();
+
+    printf("\n");
 }
 
 static void run_stack_clear() {
@@ -1352,9 +1211,6 @@ static void run_stack_clear() {
     dump_instruction("run_stack_clear");
     #endif
 
-    value_t stack_item_count = stack_pop();
-
-    for (int i = 0; i < (int)stack_item_count.as.number; i++) {
-        stack_pop();
-    }
+    int stack_item_count = next();
+    vm.stack_top -= stack_item_count;
 }
\ No newline at end of file
@@ -8,42 +8,57 @@
 #include "compiler/compiler.h"
 #include "compiler/bytecode.h"
 #include "vm/vm.h"
+#include "vm/register_vm.h"
 #include "vm/output.h"
+#include "vm/natives.h"
 #include "utils/common.h"
+#include "utils/memory.h"
 #include "utils/io.h"
 
 static int tests_total = 0;
 static int tests_passed = 0;
 
 static value_t create_number(double number_value) {
-    value_t value;
-    value.type = TYPE_NUMBER;
-    value.as.number = number_value;
-    return value;
+    return NUMBER_VALUE(number_value);
 }
 
 static value_t create_boolean(bool boolean_value) {
-    value_t value;
-    value.type = TYPE_BOOLEAN;
-    value.as.boolean = boolean_value;
-    return value;
+    return BOOLEAN_VALUE(boolean_value);
 }
 
+// expected strings are interned, so they carry a string prefix like the strings of the program, but are never collected
 static value_t create_string(char* string_value) {
-    value_t value;
-    value.type = TYPE_STRING;
-    value.as.string = string_value;
-    return value;
+    return STRING_VALUE(memory_intern_string(string_value, strlen(string_value)));
 }
 
+// expected arrays are allocated outside of the managed heap, so collections during a test run cannot free them
 static value_t create_array(int size) {
-    value_t value;
-    value.type = TYPE_ARRAY;
-    array_t* array = array_init(size);
-    value.as.array = *array;
-    return value;
+    array_t* array = (array_t*)malloc(sizeof(array_t));
+    array->size = size;
+    array->capacity = size;
+    array->refcount = 0;
+    array->kind = ARRAY_VALUES;
+    array->elements.values = (value_t*)malloc(size * sizeof(value_t));
+    return ARRAY_VALUE(array);
 }
 
+static value_t create_map(int capacity) {
+    map_t* map = (map_t*)malloc(sizeof(map_t));
+    map->count = 0;
+    map->capacity = capacity < MAP_MIN_CAPACITY ? MAP_MIN_CAPACITY : capacity;
+    map->refcount = 0;
+    map->entries = (map_entry_t*)malloc(map->capacity * sizeof(map_entry_t));
+    map->buckets = (int*)malloc(map->capacity * 2 * sizeof(int));
+
+    for (int i = 0; i < map->capacity * 2; i++) {
+        map->buckets[i] = -1;
+    }
+
+    return MAP_VALUE(map);
+}
+
+static bool compare_map(map_t* expected, map_t* actual, char* test_name, int index);
+
 static bool compare_number(number_t expected, number_t actual, char* test_name, int index) {
     if (expected != actual) {
         printf("\033[31mFAILED:\033[0m (%s) expected number value to be %.2f, got %.2f (%d. value)\n", test_name, expected, actual, index);
@@ -71,39 +86,44 @@ static bool compare_string(string_t expected, string_t actual, char* test_name,
     return true;
 }
 
-static bool compare_array(array_t expected, array_t actual, char* test_name, int index) {
-    if (expected.size != actual.size) {
-        printf("\033[31mFAILED:\033[0m (%s) expected array size to be \"%d\", got \"%d\" (%d. value)\n", test_name, expected.size, actual.size, index);
+static bool compare_array(array_t* expected, array_t* actual, char* test_name, int index) {
+    if (expected->size != actual->size) {
+        printf("\033[31mFAILED:\033[0m (%s) expected array size to be \"%d\", got \"%d\" (%d. value)\n", test_name, expected->size, actual->size, index);
         return false;
     }
 
-    for (int i = 0; i < expected.size; i++) {
-        value_t expected_element = expected.elements[i];
-        value_t actual_element = actual.elements[i];
+    for (int i = 0; i < expected->size; i++) {
+        value_t expected_element = array_get_element(expected, i);
+        value_t actual_element = array_get_element(actual, i);
 
-        if (expected_element.type != actual_element.type) {
-            printf("\033[31mFAILED:\033[0m (%s) expected value type to be %d, got %d (%d. value)\n", test_name, expected_element.type, actual_element.type, index);
+        if (value_get_type(expected_element) != value_get_type(actual_element)) {
+            printf("\033[31mFAILED:\033[0m (%s) expected value type to be %d, got %d (%d. value)\n", test_name, value_get_type(expected_element), value_get_type(actual_element), index);
             return false;
         }
 
-        switch (expected_element.type) {
+        switch (value_get_type(expected_element)) {
             case TYPE_NUMBER: {
-                bool result = compare_number(expected_element.as.number, actual_element.as.number, test_name, index);
+                bool result = compare_number(AS_NUMBER(expected_element), AS_NUMBER(actual_element), test_name, index);
                 if (!result) return false;
                 break;
             }
             case TYPE_BOOLEAN: {
-                bool result = compare_boolean(expected_element.as.boolean, actual_element.as.boolean, test_name, index);
+                bool result = compare_boolean(AS_BOOLEAN(expected_element), AS_BOOLEAN(actual_element), test_name, index);
                 if (!result) return false;
                 break;
             }
             case TYPE_STRING: {
-                bool result = compare_string(expected_element.as.string, actual_element.as.string, test_name, index);
+                bool result = compare_string(AS_STRING(expected_element), AS_STRING(actual_element), test_name, index);
                 if (!result) return false;
                 break;
             }
             case TYPE_ARRAY: {
-                bool result = compare_array(expected_element.as.array, actual_element.as.array, test_name, index);
+                bool result = compare_array(AS_ARRAY(expected_element), AS_ARRAY(actual_element), test_name, index);
+                if (!result) return false;
+                break;
+            }
+            case TYPE_MAP: {
+                bool result = compare_map(AS_MAP(expected_element), AS_MAP(actual_element), test_name, index);
                 if (!result) return false;
                 break;
             }
@@ -118,17 +138,28 @@ static bool compare_array(array_t expected, array_t actual, char* test_name, int
     return true;
 }
 
-static void test(char* test_name, char* file_path, output_t* expected_output) {
-    tests_total++;
+// maps are equal when they hold the same entries in the same order
+static bool compare_map(map_t* expected, map_t* actual, char* test_name, int index) {
+    if (expected->count != actual->count) {
+        printf("\033[31mFAILED:\033[0m (%s) expected map size to be \"%d\", got \"%d\" (%d. value)\n", test_name, expected->count, actual->count, index);
+        return false;
+    }
 
-    char* source_code = read_file(file_path);
+    array_t* expected_entries = AS_ARRAY(create_array(expected->count * 2));
+    array_t* actual_entries = AS_ARRAY(create_array(actual->count * 2));
 
-    compiler_t* compiler = compiler_init(source_code);
-    bytecode_t* bytecode = compile(compiler);
-    vm_init(bytecode);
-    vm_run(true);
+    for (int i = 0; i < expected->count; i++) {
+        expected_entries->elements.values[2 * i] = expected->entries[i].key;
+        expected_entries->elements.values[2 * i + 1] = expected->entries[i].value;
+        actual_entries->elements.values[2 * i] = actual->entries[i].key;
+        actual_entries->elements.values[2 * i + 1] = actual->entries[i].value;
+    }
 
-    output_t* actual_output = vm_get_output();
+    return compare_array(expected_entries, actual_entries, test_name, index);
+}
+
+static void check_output(char* test_name, output_t* expected_output, output_t* actual_output) {
+    tests_total++;
 
     if (actual_output->count != expected_output->count) {
         printf("\033[31mFAILED:\033[0m (%s) expected output of size %d, got %d\n", test_name, expected_output->count, actual_output->count);
@@ -139,29 +170,34 @@ static void test(char* test_name, char* file_path, output_t* expected_output) {
         value_t expected = expected_output->values[i];
         value_t actual = actual_output->values[i];
 
-        if (expected.type != actual.type) {
-            printf("\033[31mFAILED:\033[0m (%s) expected value type to be %d, got %d (%d. value)\n", test_name, expected.type, actual.type, i + 1);
+        if (value_get_type(expected) != value_get_type(actual)) {
+            printf("\033[31mFAILED:\033[0m (%s) expected value type to be %d, got %d (%d. value)\n", test_name, value_get_type(expected), value_get_type(actual), i + 1);
             return;
         }
 
-        switch (expected.type) {
+        switch (value_get_type(expected)) {
             case TYPE_NUMBER: {
-                bool result = compare_number(expected.as.number, actual.as.number, test_name, i + 1);
+                bool result = compare_number(AS_NUMBER(expected), AS_NUMBER(actual), test_name, i + 1);
                 if (!result) return;
                 break;
             }
             case TYPE_BOOLEAN: {
-                bool result = compare_boolean(expected.as.boolean, actual.as.boolean, test_name, i + 1);
+                bool result = compare_boolean(AS_BOOLEAN(expected), AS_BOOLEAN(actual), test_name, i + 1);
                 if (!result) return;
                 break;
             }
             case TYPE_STRING: {
-                bool result = compare_string(expected.as.string, actual.as.string, test_name, i + 1);
+                bool result = compare_string(AS_STRING(expected), AS_STRING(actual), test_name, i + 1);
                 if (!result) return;
                 break;
             }
             case TYPE_ARRAY: {
-                bool result = compare_array(expected.as.array, actual.as.array, test_name, i + 1);
+                bool result = compare_array(AS_ARRAY(expected), AS_ARRAY(actual), test_name, i + 1);
+                if (!result) return;
+                break;
+            }
+            case TYPE_MAP: {
+                bool result = compare_map(AS_MAP(expected), AS_MAP(actual), test_name, i + 1);
                 if (!result) return;
                 break;
             }
@@ -178,6 +214,36 @@ static void test(char* test_name, char* file_path, output_t* expected_output) {
     return;
 }
 
+static value_t native_clamp(value_t* args, int line) {
+    number_t value = AS_NUMBER(args[0]);
+    number_t min = AS_NUMBER(args[1]);
+    number_t max = AS_NUMBER(args[2]);
+
+    return create_number(value < min ? min : value > max ? max : value);
+}
+
+static value_t native_answer(value_t* args, int line) {
+    return create_number(42);
+}
+
+static void test(char* test_name, char* file_path, output_t* expected_output) {
+    char* source_code = read_file(file_path);
+
+    compiler_t* compiler = compiler_init(source_code);
+    bytecode_t* bytecode = compile(compiler);
+
+    vm_init(bytecode);
+    vm_run(true);
+    check_output(test_name, expected_output, vm_get_output());
+
+    char register_test_name[256];
+    snprintf(register_test_name, sizeof(register_test_name), "%s [register VM]", test_name);
+
+    register_vm_init(bytecode);
+    register_vm_run(true);
+    check_output(register_test_name, expected_output, register_vm_get_output());
+}
+
 int main() {
     printf("\033[32mINFO:\033[0m Starting tests\n");
     printf("--------------------------\n");
@@ -261,30 +327,30 @@ int main() {
         output_t* output = output_init();
 
         value_t array1 = create_array(3);
-        array_add_element(&array1.as.array, 0, create_number(1));
-        array_add_element(&array1.as.array, 1, create_number(2));
-        array_add_element(&array1.as.array, 2, create_number(3));
+        array_add_element(AS_ARRAY(array1), 0, create_number(1));
+        array_add_element(AS_ARRAY(array1), 1, create_number(2));
+        array_add_element(AS_ARRAY(array1), 2, create_number(3));
         output_add(output, array1);
 
         value_t array2 = create_array(4);
-        array_add_element(&array2.as.array, 0, create_number(1));
-        array_add_element(&array2.as.array, 1, create_number(2));
-        array_add_element(&array2.as.array, 2, create_number(3));
-        array_add_element(&array2.as.array, 3, create_number(4));
+        array_add_element(AS_ARRAY(array2), 0, create_number(1));
+        array_add_element(AS_ARRAY(array2), 1, create_number(2));
+        array_add_element(AS_ARRAY(array2), 2, create_number(3));
+        array_add_element(AS_ARRAY(array2), 3, create_number(4));
         output_add(output, array2);
 
         value_t array3 = create_array(6);
-        array_add_element(&array3.as.array, 0, create_number(1));
-        array_add_element(&array3.as.array, 1, create_number(2));
-        array_add_element(&array3.as.array, 2, create_number(3));
-        array_add_element(&array3.as.array, 3, create_number(4));
-        array_add_element(&array3.as.array, 4, create_number(5));
-        array_add_element(&array3.as.array, 5, create_number(6));
+        array_add_element(AS_ARRAY(array3), 0, create_number(1));
+        array_add_element(AS_ARRAY(array3), 1, create_number(2));
+        array_add_element(AS_ARRAY(array3), 2, create_number(3));
+        array_add_element(AS_ARRAY(array3), 3, create_number(4));
+        array_add_element(AS_ARRAY(array3), 4, create_number(5));
+        array_add_element(AS_ARRAY(array3), 5, create_number(6));
         output_add(output, array3);
 
         value_t array4 = create_array(2);
-        array_add_element(&array4.as.array, 0, create_number(1));
-        array_add_element(&array4.as.array, 1, create_number(2));
+        array_add_element(AS_ARRAY(array4), 0, create_number(1));
+        array_add_element(AS_ARRAY(array4), 1, create_number(2));
         output_add(output, array4);
 
         output_add(output, create_number(1));
@@ -294,15 +360,15 @@ int main() {
         output_add(output, create_number(13));
 
         value_t array5 = create_array(3);
-        array_add_element(&array5.as.array, 0, create_number(5));
-        array_add_element(&array5.as.array, 1, create_number(5));
-        array_add_element(&array5.as.array, 2, create_number(5));
+        array_add_element(AS_ARRAY(array5), 0, create_number(5));
+        array_add_element(AS_ARRAY(array5), 1, create_number(5));
+        array_add_element(AS_ARRAY(array5), 2, create_number(5));
         output_add(output, array5);
 
         value_t array6 = create_array(3);
-        array_add_element(&array6.as.array, 0, create_number(6));
-        array_add_element(&array6.as.array, 1, create_number(6));
-        array_add_element(&array6.as.array, 2, create_number(6));
+        array_add_element(AS_ARRAY(array6), 0, create_number(6));
+        array_add_element(AS_ARRAY(array6), 1, create_number(6));
+        array_add_element(AS_ARRAY(array6), 2, create_number(6));
         output_add(output, array6);
 
         output_add(output, create_number(1));
@@ -464,6 +530,618 @@ int main() {
         test("While statements", "./tests/cases/case-08-while-statements.gen", output);
     }
 
+    // TEST 09
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(5));
+        output_add(output, create_number(120));
+
+        output_add(output, create_number(11));
+
+        output_add(output, create_number(101));
+        output_add(output, create_number(11));
+
+        output_add(output, create_number(0));
+        output_add(output, create_number(1));
+        output_add(output, create_number(4));
+
+        test("Functions", "./tests/cases/case-09-functions.gen", output);
+    }
+
+    // TEST 10
+    {
+        output_t* output = output_init();
+
+        value_t values = create_array(7);
+        array_add_element(AS_ARRAY(values), 0, create_number(-1.5));
+        array_add_element(AS_ARRAY(values), 1, create_number(0));
+        array_add_element(AS_ARRAY(values), 2, create_number(1000000));
+        array_add_element(AS_ARRAY(values), 3, create_boolean(true));
+        array_add_element(AS_ARRAY(values), 4, create_boolean(false));
+        array_add_element(AS_ARRAY(values), 5, create_string("text"));
+        array_add_element(AS_ARRAY(values), 6, create_number(2));
+        output_add(output, values);
+
+        output_add(output, create_number(-0.25));
+        output_add(output, create_number(0));
+        output_add(output, create_boolean(true));
+        output_add(output, create_string("text!"));
+        output_add(output, create_number(7));
+        output_add(output, create_number(0.25));
+
+        test("Values", "./tests/cases/case-10-values.gen", output);
+    }
+
+    // TEST 11
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(150000));
+
+        value_t kept = create_array(5);
+        for (int i = 0; i < 5; i++) {
+            array_add_element(AS_ARRAY(kept), i, create_string("kept!"));
+        }
+        output_add(output, kept);
+
+        output_add(output, create_string("first"));
+
+        value_t items = create_array(2);
+        array_add_element(AS_ARRAY(items), 0, create_string("a"));
+        array_add_element(AS_ARRAY(items), 1, create_string("b"));
+        output_add(output, items);
+
+        test("Garbage collection", "./tests/cases/case-11-garbage-collection.gen", output);
+    }
+
+    // TEST 12
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_string("young value"));
+
+        value_t slot = create_array(2);
+        array_add_element(AS_ARRAY(slot), 0, create_string("slot"));
+        array_add_element(AS_ARRAY(slot), 1, create_string("ted"));
+        output_add(output, slot);
+
+        output_add(output, create_string("ted"));
+
+        test("Generations", "./tests/cases/case-12-generations.gen", output);
+    }
+
+    // TEST 13
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_string("abcdeabcde"));
+        output_add(output, create_number(30));
+        output_add(output, create_string("grown"));
+        output_add(output, create_string("a"));
+
+        test("Shapes", "./tests/cases/case-13-shapes.gen", output);
+    }
+
+    // TEST 14
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(10));
+        output_add(output, create_number(3));
+        output_add(output, create_number(2));
+        output_add(output, create_string("moved"));
+        output_add(output, create_string("point"));
+        output_add(output, create_boolean(true));
+        output_add(output, create_number(1));
+        output_add(output, create_number(0));
+        output_add(output, create_string("added"));
+
+        test("Prototypes", "./tests/cases/case-14-prototypes.gen", output);
+    }
+
+    // TEST 15
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(19));
+        output_add(output, create_number(22));
+        output_add(output, create_number(20100));
+        output_add(output, create_boolean(true));
+
+        value_t array = create_array(3);
+        array_add_element(AS_ARRAY(array), 0, create_number(2));
+        array_add_element(AS_ARRAY(array), 1, create_number(4));
+        array_add_element(AS_ARRAY(array), 2, create_number(3));
+        output_add(output, array);
+
+        test("Calls", "./tests/cases/case-15-calls.gen", output);
+    }
+
+    // TEST 16
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(0));
+        output_add(output, create_number(63));
+        output_add(output, create_number(99));
+        output_add(output, create_number(120));
+
+        test("Tables", "./tests/cases/case-16-tables.gen", output);
+    }
+
+    // TEST 17
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(false));
+        output_add(output, create_boolean(true));
+
+        test("String interning", "./tests/cases/case-17-interning.gen", output);
+    }
+
+    // TEST 18
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(6000));
+        output_add(output, create_string("b"));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(false));
+        output_add(output, create_number(0));
+        output_add(output, create_number(1));
+
+        test("String lengths", "./tests/cases/case-18-string-lengths.gen", output);
+    }
+
+    // TEST 19
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(38003));
+        output_add(output, create_string("e"));
+        output_add(output, create_string("d"));
+        output_add(output, create_string("j"));
+        output_add(output, create_number(58000));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(false));
+        output_add(output, create_string("01234567890123456789012345678901234567890123456789012345678901234567890123456789"));
+
+        value_t array = create_array(2);
+        array_add_element(AS_ARRAY(array), 0, create_string("9"));
+        array_add_element(AS_ARRAY(array), 1, create_number(80));
+        output_add(output, array);
+
+        test("Ropes", "./tests/cases/case-19-ropes.gen", output);
+    }
+
+    // TEST 20
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(900));
+        output_add(output, create_string("quick"));
+        output_add(output, create_boolean(true));
+        output_add(output, create_number(956));
+        output_add(output, create_boolean(true));
+        output_add(output, create_string("dog"));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(true));
+        output_add(output, create_string("og "));
+
+        test("Slices", "./tests/cases/case-20-slices.gen", output);
+    }
+
+    // TEST 21
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(10000));
+        output_add(output, create_number(9999));
+
+        value_t array1 = create_array(10);
+        for (int i = 0; i < 10; i++) {
+            array_add_element(AS_ARRAY(array1), i, create_number(i));
+        }
+        output_add(output, array1);
+
+        output_add(output, create_number(11));
+        output_add(output, create_number(10));
+        output_add(output, create_number(0));
+
+        value_t array2 = create_array(1);
+        array_add_element(AS_ARRAY(array2), 0, create_number(1));
+        output_add(output, array2);
+
+        test("Array capacity", "./tests/cases/case-21-array-capacity.gen", output);
+    }
+
+    // TEST 22
+    {
+        output_t* output = output_init();
+
+        value_t a = create_array(3);
+        value_t b = create_array(4);
+        for (int i = 0; i < 3; i++) {
+            array_add_element(AS_ARRAY(a), i, create_number(i + 1));
+            array_add_element(AS_ARRAY(b), i, create_number(i + 1));
+        }
+        array_add_element(AS_ARRAY(b), 0, create_number(10));
+        array_add_element(AS_ARRAY(b), 3, create_number(4));
+        output_add(output, a);
+        output_add(output, b);
+
+        output_add(output, create_number(3));
+
+        value_t c = create_array(4);
+        for (int i = 0; i < 3; i++) {
+            array_add_element(AS_ARRAY(c), i, create_number(i + 1));
+        }
+        array_add_element(AS_ARRAY(c), 3, create_number(5));
+        output_add(output, c);
+
+        value_t row = create_array(3);
+        array_add_element(AS_ARRAY(row), 0, create_number(1));
+        array_add_element(AS_ARRAY(row), 1, create_number(20));
+        array_add_element(AS_ARRAY(row), 2, create_number(3));
+        output_add(output, row);
+        output_add(output, a);
+        output_add(output, a);
+
+        value_t items = create_array(4);
+        array_add_element(AS_ARRAY(items), 0, create_number(30));
+        array_add_element(AS_ARRAY(items), 1, create_number(2));
+        array_add_element(AS_ARRAY(items), 2, create_number(3));
+        array_add_element(AS_ARRAY(items), 3, create_number(6));
+        output_add(output, items);
+        output_add(output, a);
+
+        value_t copy = create_array(2);
+        array_add_element(AS_ARRAY(copy), 0, create_number(1));
+        array_add_element(AS_ARRAY(copy), 1, create_number(2));
+        output_add(output, copy);
+
+        value_t shared = create_array(1);
+        array_add_element(AS_ARRAY(shared), 0, create_number(1));
+        output_add(output, shared);
+
+        output_add(output, create_number(20000));
+        output_add(output, create_number(20004));
+
+        test("Copy on write", "./tests/cases/case-22-copy-on-write.gen", output);
+    }
+
+    // TEST 23
+    {
+        output_t* output = output_init();
+
+        value_t numbers = create_array(3);
+        array_add_element(AS_ARRAY(numbers), 0, create_number(1));
+        array_add_element(AS_ARRAY(numbers), 1, create_number(4));
+        array_add_element(AS_ARRAY(numbers), 2, create_number(3));
+        output_add(output, numbers);
+
+        value_t flags = create_array(3);
+        array_add_element(AS_ARRAY(flags), 0, create_boolean(false));
+        array_add_element(AS_ARRAY(flags), 1, create_boolean(false));
+        array_add_element(AS_ARRAY(flags), 2, create_boolean(true));
+        output_add(output, flags);
+
+        value_t mixed = create_array(4);
+        array_add_element(AS_ARRAY(mixed), 0, create_number(1));
+        array_add_element(AS_ARRAY(mixed), 1, create_number(4));
+        array_add_element(AS_ARRAY(mixed), 2, create_string("three"));
+        array_add_element(AS_ARRAY(mixed), 3, create_boolean(false));
+        output_add(output, mixed);
+        output_add(output, numbers);
+
+        value_t empty = create_array(2);
+        array_add_element(AS_ARRAY(empty), 0, create_string("first"));
+        array_add_element(AS_ARRAY(empty), 1, create_number(2));
+        output_add(output, empty);
+
+        value_t emptied = create_array(1);
+        array_add_element(AS_ARRAY(emptied), 0, create_boolean(true));
+        output_add(output, emptied);
+
+        output_add(output, create_number(5000));
+        output_add(output, create_string("item"));
+        output_add(output, create_string("zero"));
+        output_add(output, create_number(4999 * 4999));
+
+        test("Array kinds", "./tests/cases/case-23-array-kinds.gen", output);
+    }
+
+    // TEST 24
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(18.5));
+        output_add(output, create_number(-6));
+        output_add(output, create_number(9));
+        output_add(output, create_number(3));
+        output_add(output, create_number(0));
+        output_add(output, create_number(18.5));
+        output_add(output, create_number(11));
+
+        value_t doubled = create_array(9);
+        number_t values[] = {8, -4, 15, 2, 0, 6, 18, -12, 4};
+        for (int i = 0; i < 9; i++) {
+            array_add_element(AS_ARRAY(doubled), i, create_number(values[i]));
+        }
+        output_add(output, doubled);
+        output_add(output, create_number(7.5));
+
+        value_t strings = create_array(3);
+        for (int i = 0; i < 3; i++) {
+            array_add_element(AS_ARRAY(strings), i, create_string("x"));
+        }
+        output_add(output, strings);
+        output_add(output, create_array(0));
+
+        output_add(output, create_number(3));
+        output_add(output, create_number(499500));
+        output_add(output, create_number(0));
+        output_add(output, create_number(0));
+
+        test("Array builtins", "./tests/cases/case-24-array-builtins.gen", output);
+    }
+
+    // TEST 25
+    {
+        natives_register("clamp", 3, native_clamp);
+        natives_register("answer", 0, native_answer);
+
+        output_t* output = output_init();
+
+        output_add(output, create_number(10));
+        output_add(output, create_number(0));
+        output_add(output, create_number(4));
+        output_add(output, create_number(42));
+        output_add(output, create_number(8));
+        output_add(output, create_number(5));
+        output_add(output, create_number(3));
+
+        test("Natives", "./tests/cases/case-25-natives.gen", output);
+    }
+
+    // TEST 26
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(31));
+        output_add(output, create_number(3));
+        output_add(output, create_number(28));
+        output_add(output, create_boolean(false));
+        output_add(output, create_number(0));
+
+        value_t names = create_array(2);
+        array_add_element(AS_ARRAY(names), 0, create_string("carol"));
+        array_add_element(AS_ARRAY(names), 1, create_string("bob"));
+        output_add(output, names);
+
+        value_t ages = create_array(3);
+        array_add_element(AS_ARRAY(ages), 0, create_number(0));
+        array_add_element(AS_ARRAY(ages), 1, create_number(28));
+        array_add_element(AS_ARRAY(ages), 2, create_number(45));
+        output_add(output, ages);
+
+        output_add(output, create_number(3));
+        output_add(output, create_number(2));
+
+        value_t words = create_array(3);
+        array_add_element(AS_ARRAY(words), 0, create_string("a"));
+        array_add_element(AS_ARRAY(words), 1, create_string("b"));
+        array_add_element(AS_ARRAY(words), 2, create_string("c"));
+        output_add(output, words);
+
+        value_t counts = create_map(3);
+        map_set(AS_MAP(counts), create_string("a"), create_number(3));
+        map_set(AS_MAP(counts), create_string("b"), create_number(2));
+        map_set(AS_MAP(counts), create_string("c"), create_number(1));
+        output_add(output, counts);
+
+        output_add(output, create_string("one"));
+        output_add(output, create_string("yes"));
+
+        value_t nested = create_array(2);
+        array_add_element(AS_ARRAY(nested), 0, create_number(5));
+        array_add_element(AS_ARRAY(nested), 1, create_number(2));
+        output_add(output, nested);
+
+        output_add(output, create_number(1));
+        output_add(output, create_number(5));
+
+        output_add(output, create_number(2));
+        output_add(output, create_number(0));
+        output_add(output, create_number(1));
+        output_add(output, create_number(0));
+
+        output_add(output, create_number(10000));
+        output_add(output, create_number(39601));
+        output_add(output, create_boolean(false));
+        output_add(output, create_number(1333333330000));
+
+        test("Maps", "./tests/cases/case-26-maps.gen", output);
+    }
+
+    // TEST 27
+    {
+        output_t* output = output_init();
+
+        value_t starts = create_array(4);
+        value_t counts = create_array(4);
+        number_t start_values[] = {0, 10, 40, 50};
+        number_t count_values[] = {2, 2, 3, 1};
+        for (int i = 0; i < 4; i++) {
+            array_add_element(AS_ARRAY(starts), i, create_number(start_values[i]));
+            array_add_element(AS_ARRAY(counts), i, create_number(count_values[i]));
+        }
+        output_add(output, starts);
+        output_add(output, counts);
+        output_add(output, create_number(4));
+
+        output_add(output, create_number(0));
+        output_add(output, create_number(30));
+        output_add(output, create_number(40));
+        output_add(output, create_number(-1));
+
+        value_t range = create_array(3);
+        array_add_element(AS_ARRAY(range), 0, create_number(10));
+        array_add_element(AS_ARRAY(range), 1, create_number(30));
+        array_add_element(AS_ARRAY(range), 2, create_number(40));
+        output_add(output, range);
+
+        value_t range_values = create_array(3);
+        array_add_element(AS_ARRAY(range_values), 0, create_number(0));
+        array_add_element(AS_ARRAY(range_values), 1, create_number(3));
+        array_add_element(AS_ARRAY(range_values), 2, create_number(1));
+        output_add(output, range_values);
+
+        value_t words = create_array(3);
+        array_add_element(AS_ARRAY(words), 0, create_string("apple"));
+        array_add_element(AS_ARRAY(words), 1, create_string("peach"));
+        array_add_element(AS_ARRAY(words), 2, create_string("pear"));
+        output_add(output, words);
+        output_add(output, create_string("peach"));
+        output_add(output, create_string("none"));
+
+        output_add(output, create_number(20000));
+        output_add(output, create_number(1522756));
+
+        value_t middle = create_array(6);
+        for (int i = 0; i < 6; i++) {
+            array_add_element(AS_ARRAY(middle), i, create_number(9997 + i));
+        }
+        output_add(output, middle);
+        output_add(output, create_number(199990000));
+
+        test("Ordered maps", "./tests/cases/case-27-ordered-maps.gen", output);
+    }
+
+    // TEST 28
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(4));
+        output_add(output, create_string("zero"));
+        output_add(output, create_number(3));
+        output_add(output, create_number(3));
+        output_add(output, create_string("zero"));
+        output_add(output, create_number(1));
+        output_add(output, create_number(2));
+
+        output_add(output, create_number(3));
+        output_add(output, create_number(5));
+
+        output_add(output, create_number(1003));
+        output_add(output, create_number(498));
+
+        output_add(output, create_number(998));
+        output_add(output, create_number(999));
+        output_add(output, create_number(1000));
+        output_add(output, create_number(0));
+        output_add(output, create_number(16));
+
+        test("Deques", "./tests/cases/case-28-deques.gen", output);
+    }
+
+    // TEST 29
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(4));
+        output_add(output, create_string("plan"));
+        output_add(output, create_number(1));
+        output_add(output, create_string("plan"));
+
+        value_t review = create_array(2);
+        array_add_element(AS_ARRAY(review), 0, create_string("review"));
+        array_add_element(AS_ARRAY(review), 1, create_number(2));
+        output_add(output, review);
+
+        output_add(output, create_string("fix"));
+        output_add(output, create_string("write"));
+        output_add(output, create_number(1));
+
+        output_add(output, create_boolean(true));
+        output_add(output, create_number(9998));
+        output_add(output, create_number(236));
+
+        test("Priority queues", "./tests/cases/case-29-priority-queues.gen", output);
+    }
+
+    // TEST 30
+    {
+        output_t* output = output_init();
+
+        output_add(output, create_number(70));
+        output_add(output, create_number(4));
+        output_add(output, create_boolean(true));
+        output_add(output, create_boolean(false));
+
+        output_add(output, create_boolean(false));
+        output_add(output, create_number(3));
+
+        output_add(output, create_number(500));
+        output_add(output, create_number(44));
+        output_add(output, create_number(522));
+        output_add(output, create_number(22));
+        output_add(output, create_number(1000));
+        output_add(output, create_number(130));
+        output_add(output, create_number(3));
+        output_add(output, create_number(0));
+        output_add(output, create_number(0));
+
+        output_add(output, create_number(40000));
+
+        test("Bitsets", "./tests/cases/case-30-bitsets.gen", output);
+    }
+
+    // TEST 31
+    {
+        output_t* output = output_init();
+
+        value_t inner = create_array(3);
+        for (int i = 0; i < 3; i++) {
+            array_add_element(AS_ARRAY(inner), i, create_number(i + 1));
+        }
+        value_t outer = create_array(3);
+        array_add_element(AS_ARRAY(outer), 0, inner);
+        array_add_element(AS_ARRAY(outer), 1, create_number(2));
+        array_add_element(AS_ARRAY(outer), 2, create_number(3));
+        output_add(output, outer);
+        output_add(output, inner);
+
+        value_t pair = create_array(2);
+        array_add_element(AS_ARRAY(pair), 0, create_number(1));
+        array_add_element(AS_ARRAY(pair), 1, create_number(2));
+        value_t wrapped = create_array(1);
+        array_add_element(AS_ARRAY(wrapped), 0, pair);
+        value_t nested = create_array(2);
+        array_add_element(AS_ARRAY(nested), 0, create_number(1));
+        array_add_element(AS_ARRAY(nested), 1, wrapped);
+        output_add(output, nested);
+
+        value_t one = create_array(1);
+        array_add_element(AS_ARRAY(one), 0, create_number(1));
+        value_t doubled = create_array(2);
+        array_add_element(AS_ARRAY(doubled), 0, create_number(1));
+        array_add_element(AS_ARRAY(doubled), 1, one);
+        output_add(output, doubled);
+        output_add(output, create_number(3));
+        output_add(output, doubled);
+
+        output_add(output, one);
+        output_add(output, create_number(1));
+
+        test("Self store", "./tests/cases/case-31-self-store.gen", output);
+    }
+
     printf("--------------------------\n");
 
     if (tests_passed == tests_total) {